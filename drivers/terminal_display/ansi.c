@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "ansi.h"
+#include <zephyr/sys/__assert.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the longest single sequence put in one go, a truecolor SGR */
+#define ANSI_MAX_SEQUENCE 24
+
+static size_t ansi_digits(uint32_t n)
+{
+    size_t digits = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+/* length of CSI <n> <final>, where a parameter of 1 can be left out */
+static size_t ansi_csi_length(uint32_t n)
+{
+    return n == 1 ? 3 : 3 + ansi_digits(n);
+}
+
+/* makes sure there is room for one more sequence */
+static void ansi_reserve(struct ansi_encoder *encoder)
+{
+    if (encoder->length + ANSI_MAX_SEQUENCE > sizeof(encoder->buffer))
+    {
+        ansi_flush(encoder);
+    }
+}
+
+static void ansi_put_char(struct ansi_encoder *encoder, char c)
+{
+    encoder->buffer[encoder->length++] = (uint8_t)c;
+}
+
+static void ansi_put_string(struct ansi_encoder *encoder, const char *string)
+{
+    while (*string != '\0')
+    {
+        ansi_put_char(encoder, *string++);
+    }
+}
+
+static void ansi_put_number(struct ansi_encoder *encoder, uint32_t n)
+{
+    const size_t digits = ansi_digits(n);
+    for (size_t i = digits; i > 0; i--)
+    {
+        encoder->buffer[encoder->length + i - 1] = '0' + (n % 10);
+        n /= 10;
+    }
+    encoder->length += digits;
+}
+
+static void ansi_put_csi(struct ansi_encoder *encoder, uint32_t n, char final)
+{
+    ansi_reserve(encoder);
+    ansi_put_string(encoder, "\x1b[");
+    if (n != 1)
+    {
+        ansi_put_number(encoder, n);
+    }
+    ansi_put_char(encoder, final);
+}
+
+void ansi_encoder_init(struct ansi_encoder *encoder, struct ansi_state *state, ansi_sink_t sink,
+                       void *user_data, uint16_t columns)
+{
+    __ASSERT_NO_MSG(encoder != NULL);
+    __ASSERT_NO_MSG(state != NULL);
+    __ASSERT_NO_MSG(sink != NULL);
+
+    encoder->state = state;
+    encoder->sink = sink;
+    encoder->user_data = user_data;
+    encoder->columns = columns;
+    encoder->rep = false;
+    encoder->ech = false;
+    encoder->length = 0;
+}
+
+static size_t ansi_cup_length(uint16_t row, uint16_t column)
+{
+    if (column == 0)
+    {
+        return row == 0 ? 3 : 3 + ansi_digits(row + 1);
+    }
+    return 4 + ansi_digits(row + 1) + ansi_digits(column + 1);
+}
+
+static size_t ansi_relative_length(int32_t distance)
+{
+    return distance == 0 ? 0 : ansi_csi_length(abs(distance));
+}
+
+/* moving down with line feeds is cheaper than CUD for short distances */
+static size_t ansi_down_length(uint16_t rows)
+{
+    return MIN(rows, ansi_csi_length(rows));
+}
+
+static void ansi_put_relative(struct ansi_encoder *encoder, int32_t distance, char forward, char backward)
+{
+    if (distance > 0)
+    {
+        ansi_put_csi(encoder, distance, forward);
+    }
+    else if (distance < 0)
+    {
+        ansi_put_csi(encoder, -distance, backward);
+    }
+}
+
+void ansi_move_cursor(struct ansi_encoder *encoder, uint16_t row, uint16_t column)
+{
+    __ASSERT_NO_MSG(encoder != NULL);
+    struct ansi_state *state = encoder->state;
+
+    const bool valid = state->cursor.valid;
+    // at or past the edge the terminal may be holding a pending wrap,
+    // so only the row is known for sure
+    const bool exact = valid && state->cursor.column < encoder->columns;
+
+    if (exact && state->cursor.row == row && state->cursor.column == column)
+    {
+        return;
+    }
+
+    // candidates: absolute CUP, CUU/CUD then CUF/CUB from where the cursor
+    // is, or CR then down/up then CUF from the start of the line
+    const size_t absolute = ansi_cup_length(row, column);
+    size_t relative = SIZE_MAX;
+    size_t carriage_return = SIZE_MAX;
+
+    const int32_t rows = (int32_t)row - state->cursor.row;
+    if (exact)
+    {
+        relative = ansi_relative_length(rows) + ansi_relative_length((int32_t)column - state->cursor.column);
+    }
+    if (valid)
+    {
+        carriage_return = 1 + (rows > 0 ? ansi_down_length(rows) : ansi_relative_length(rows)) +
+                          ansi_relative_length(column);
+    }
+
+    if (absolute <= relative && absolute <= carriage_return)
+    {
+        ansi_reserve(encoder);
+        ansi_put_string(encoder, "\x1b[");
+        if (row != 0 || column != 0)
+        {
+            // Note: Terminal coordinates are 1-based
+            ansi_put_number(encoder, row + 1);
+        }
+        if (column != 0)
+        {
+            ansi_put_char(encoder, ';');
+            ansi_put_number(encoder, column + 1);
+        }
+        ansi_put_char(encoder, 'H');
+    }
+    else if (relative <= carriage_return)
+    {
+        ansi_put_relative(encoder, rows, 'B', 'A');
+        ansi_put_relative(encoder, (int32_t)column - state->cursor.column, 'C', 'D');
+    }
+    else
+    {
+        ansi_reserve(encoder);
+        ansi_put_char(encoder, '\r');
+        // line feeds are only used after a carriage return, so it doesn't
+        // matter whether the terminal adds an implicit one. They never
+        // scroll either, since the target row is below the cursor.
+        if (rows > 0 && (size_t)rows < ansi_csi_length(rows))
+        {
+            for (int32_t i = 0; i < rows; i++)
+            {
+                ansi_put_char(encoder, '\n');
+            }
+        }
+        else
+        {
+            ansi_put_relative(encoder, rows, 'B', 'A');
+        }
+        ansi_put_relative(encoder, column, 'C', 'D');
+    }
+
+    state->cursor.valid = true;
+    state->cursor.row = row;
+    state->cursor.column = column;
+}
+
+void ansi_set_background(struct ansi_encoder *encoder, uint32_t code)
+{
+    __ASSERT_NO_MSG(encoder != NULL);
+    struct ansi_state *state = encoder->state;
+
+    if (state->background.valid && state->background.code == code)
+    {
+        return;
+    }
+
+    const uint32_t value = code & 0xffffff;
+    ansi_reserve(encoder);
+
+    switch ((enum terminal_display_color_mode)(code >> 24))
+    {
+    case TERMINAL_DISPLAY_COLOR_MODE_TRUECOLOR:
+        ansi_put_string(encoder, "\x1b[48;2;");
+        ansi_put_number(encoder, value >> 16);
+        ansi_put_char(encoder, ';');
+        ansi_put_number(encoder, (value >> 8) & 0xff);
+        ansi_put_char(encoder, ';');
+        ansi_put_number(encoder, value & 0xff);
+        break;
+    case TERMINAL_DISPLAY_COLOR_MODE_16:
+    case TERMINAL_DISPLAY_COLOR_MODE_8:
+        // the bright half of the palette has its own, equally short, SGR
+        ansi_put_string(encoder, value < 8 ? "\x1b[4" : "\x1b[10");
+        ansi_put_number(encoder, value % 8);
+        break;
+    case TERMINAL_DISPLAY_COLOR_MODE_256:
+    default:
+        ansi_put_string(encoder, "\x1b[48;5;");
+        ansi_put_number(encoder, value);
+        break;
+    }
+    ansi_put_char(encoder, 'm');
+
+    state->background.valid = true;
+    state->background.code = code;
+}
+
+void ansi_fill(struct ansi_encoder *encoder, uint16_t cells)
+{
+    __ASSERT_NO_MSG(encoder != NULL);
+    struct ansi_state *state = encoder->state;
+
+    if (cells == 0)
+    {
+        return;
+    }
+
+    // candidates: literal spaces, one space repeated with REP, or ECH.
+    // ECH leaves the cursor where it was, so it's charged for the CUF
+    // that usually follows it.
+    const size_t literal = cells;
+    const size_t repeat = encoder->rep && cells > 1 ? 1 + ansi_csi_length(cells - 1) : SIZE_MAX;
+    const size_t erase = encoder->ech ? 2 * ansi_csi_length(cells) : SIZE_MAX;
+
+    if (literal <= repeat && literal <= erase)
+    {
+        for (uint16_t i = 0; i < cells; i++)
+        {
+            if (encoder->length == sizeof(encoder->buffer))
+            {
+                ansi_flush(encoder);
+            }
+            ansi_put_char(encoder, ' ');
+        }
+    }
+    else if (repeat <= erase)
+    {
+        ansi_reserve(encoder);
+        ansi_put_char(encoder, ' ');
+        ansi_put_csi(encoder, cells - 1, 'b');
+    }
+    else
+    {
+        ansi_put_csi(encoder, cells, 'X');
+        return;
+    }
+
+    state->cursor.column += cells;
+}
+
+void ansi_reset(struct ansi_encoder *encoder)
+{
+    __ASSERT_NO_MSG(encoder != NULL);
+
+    ansi_reserve(encoder);
+    ansi_put_string(encoder, "\x1b[0m");
+    encoder->state->cursor.valid = false;
+    encoder->state->background.valid = false;
+}
+
+void ansi_flush(struct ansi_encoder *encoder)
+{
+    __ASSERT_NO_MSG(encoder != NULL);
+
+    if (encoder->length > 0)
+    {
+        encoder->sink(encoder->user_data, encoder->buffer, encoder->length);
+        encoder->length = 0;
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __TERMINAL_DISPLAY_ANSI_H__
+#define __TERMINAL_DISPLAY_ANSI_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <terminal_display/terminal_display.h>
+
+/* A background color in a given encoding. The mode lives in the top byte,
+ * so codes from different encodings never compare equal. The value is a
+ * palette index, or 0xRRGGBB for truecolor. */
+#define ANSI_CODE(mode, value) (((uint32_t)(mode) << 24) | ((uint32_t)(value) & 0xffffff))
+
+/* what the encoder believes the terminal currently looks like */
+struct ansi_state
+{
+    struct
+    {
+        bool valid;
+        uint16_t row;
+        uint16_t column;
+    } cursor;
+    struct
+    {
+        bool valid;
+        uint32_t code;
+    } background;
+};
+
+typedef void (*ansi_sink_t)(void *user_data, const uint8_t *data, size_t length);
+
+/* Turns drawing operations into the shortest escape sequences it can find,
+ * given what it knows about the terminal's state. Output is buffered and
+ * handed to the sink in chunks. */
+struct ansi_encoder
+{
+    struct ansi_state *state;
+    ansi_sink_t sink;
+    void *user_data;
+    /* the cursor position is only trusted left of this column. Past it
+     * the terminal may be holding a pending wrap, which relative cursor
+     * motion doesn't account for */
+    uint16_t columns;
+    /* the terminal supports REP (CSI n b) */
+    bool rep;
+    /* the terminal supports ECH (CSI n X) with background color erase */
+    bool ech;
+    size_t length;
+    uint8_t buffer[64];
+};
+
+void ansi_encoder_init(struct ansi_encoder *encoder, struct ansi_state *state, ansi_sink_t sink,
+                       void *user_data, uint16_t columns);
+
+/* moves the cursor to a 0-based row and column */
+void ansi_move_cursor(struct ansi_encoder *encoder, uint16_t row, uint16_t column);
+
+/* sets the background color, see ANSI_CODE() */
+void ansi_set_background(struct ansi_encoder *encoder, uint32_t code);
+
+/* paints cells in the current background color, starting at the cursor */
+void ansi_fill(struct ansi_encoder *encoder, uint16_t cells);
+
+/* restores the default attributes and forgets the terminal's state */
+void ansi_reset(struct ansi_encoder *encoder);
+
+/* hands everything buffered to the sink */
+void ansi_flush(struct ansi_encoder *encoder);
+
+#endif
@@ -6,14 +6,6 @@
 #include "rgb24.h"
 #include <zephyr/sys/__assert.h>
 #include <stddef.h>
-#include <stdlib.h>
-
-bool rgb24_equal(const struct rgb24 *a, const struct rgb24 *b)
-{
-    __ASSERT_NO_MSG(a != NULL);
-    __ASSERT_NO_MSG(b != NULL);
-    return a->r == b->r && a->g == b->g && a->b == b->b;
-}
 
 bool rgb24_is_grayscale(const struct rgb24 *color)
 {
@@ -21,33 +13,226 @@ bool rgb24_is_grayscale(const struct rgb24 *color)
     return color->r == color->g && color->g == color->b;
 }
 
-static uint32_t calc_distance(uint8_t target, uint8_t index)
+/* where a channel value lies between two palette levels */
+struct rgb24_step
+{
+    /* the level at or below the value */
+    uint8_t level;
+    /* how far the value is towards the next level up, in 256ths */
+    uint8_t fraction;
+};
+
+/* steps for the levels of the 6x6x6 cube (0, 95, 135, 175, 215, 255),
+ * generated from the levels */
+static const struct rgb24_step cube_steps[256] = {
+    {0,   0}, {0,   2}, {0,   5}, {0,   8}, {0,  10}, {0,  13}, {0,  16}, {0,  18},
+    {0,  21}, {0,  24}, {0,  26}, {0,  29}, {0,  32}, {0,  35}, {0,  37}, {0,  40},
+    {0,  43}, {0,  45}, {0,  48}, {0,  51}, {0,  53}, {0,  56}, {0,  59}, {0,  61},
+    {0,  64}, {0,  67}, {0,  70}, {0,  72}, {0,  75}, {0,  78}, {0,  80}, {0,  83},
+    {0,  86}, {0,  88}, {0,  91}, {0,  94}, {0,  97}, {0,  99}, {0, 102}, {0, 105},
+    {0, 107}, {0, 110}, {0, 113}, {0, 115}, {0, 118}, {0, 121}, {0, 123}, {0, 126},
+    {0, 129}, {0, 132}, {0, 134}, {0, 137}, {0, 140}, {0, 142}, {0, 145}, {0, 148},
+    {0, 150}, {0, 153}, {0, 156}, {0, 158}, {0, 161}, {0, 164}, {0, 167}, {0, 169},
+    {0, 172}, {0, 175}, {0, 177}, {0, 180}, {0, 183}, {0, 185}, {0, 188}, {0, 191},
+    {0, 194}, {0, 196}, {0, 199}, {0, 202}, {0, 204}, {0, 207}, {0, 210}, {0, 212},
+    {0, 215}, {0, 218}, {0, 220}, {0, 223}, {0, 226}, {0, 229}, {0, 231}, {0, 234},
+    {0, 237}, {0, 239}, {0, 242}, {0, 245}, {0, 247}, {0, 250}, {0, 253}, {1,   0},
+    {1,   6}, {1,  12}, {1,  19}, {1,  25}, {1,  32}, {1,  38}, {1,  44}, {1,  51},
+    {1,  57}, {1,  64}, {1,  70}, {1,  76}, {1,  83}, {1,  89}, {1,  96}, {1, 102},
+    {1, 108}, {1, 115}, {1, 121}, {1, 128}, {1, 134}, {1, 140}, {1, 147}, {1, 153},
+    {1, 160}, {1, 166}, {1, 172}, {1, 179}, {1, 185}, {1, 192}, {1, 198}, {1, 204},
+    {1, 211}, {1, 217}, {1, 224}, {1, 230}, {1, 236}, {1, 243}, {1, 249}, {2,   0},
+    {2,   6}, {2,  12}, {2,  19}, {2,  25}, {2,  32}, {2,  38}, {2,  44}, {2,  51},
+    {2,  57}, {2,  64}, {2,  70}, {2,  76}, {2,  83}, {2,  89}, {2,  96}, {2, 102},
+    {2, 108}, {2, 115}, {2, 121}, {2, 128}, {2, 134}, {2, 140}, {2, 147}, {2, 153},
+    {2, 160}, {2, 166}, {2, 172}, {2, 179}, {2, 185}, {2, 192}, {2, 198}, {2, 204},
+    {2, 211}, {2, 217}, {2, 224}, {2, 230}, {2, 236}, {2, 243}, {2, 249}, {3,   0},
+    {3,   6}, {3,  12}, {3,  19}, {3,  25}, {3,  32}, {3,  38}, {3,  44}, {3,  51},
+    {3,  57}, {3,  64}, {3,  70}, {3,  76}, {3,  83}, {3,  89}, {3,  96}, {3, 102},
+    {3, 108}, {3, 115}, {3, 121}, {3, 128}, {3, 134}, {3, 140}, {3, 147}, {3, 153},
+    {3, 160}, {3, 166}, {3, 172}, {3, 179}, {3, 185}, {3, 192}, {3, 198}, {3, 204},
+    {3, 211}, {3, 217}, {3, 224}, {3, 230}, {3, 236}, {3, 243}, {3, 249}, {4,   0},
+    {4,   6}, {4,  12}, {4,  19}, {4,  25}, {4,  32}, {4,  38}, {4,  44}, {4,  51},
+    {4,  57}, {4,  64}, {4,  70}, {4,  76}, {4,  83}, {4,  89}, {4,  96}, {4, 102},
+    {4, 108}, {4, 115}, {4, 121}, {4, 128}, {4, 134}, {4, 140}, {4, 147}, {4, 153},
+    {4, 160}, {4, 166}, {4, 172}, {4, 179}, {4, 185}, {4, 192}, {4, 198}, {4, 204},
+    {4, 211}, {4, 217}, {4, 224}, {4, 230}, {4, 236}, {4, 243}, {4, 249}, {5,   0},
+};
+
+/* the index of a palette level, rounded up if the value is at least
+ * threshold 256ths of the way to the next level */
+static inline uint8_t rgb24_step_round(const struct rgb24_step *step, uint8_t threshold)
 {
-    uint32_t value = index > 215 ? index * 10 - 2152 : index * 40 + (index > 0 ? 55 : 0);
-    return abs(target - value);
+    return step->level + (step->fraction >= threshold);
+}
+
+uint8_t rgb24_to_256_dithered(const struct rgb24 *color, uint8_t threshold)
+{
+    __ASSERT_NO_MSG(color != NULL);
+    const uint8_t r = rgb24_step_round(&cube_steps[color->r], threshold);
+    const uint8_t g = rgb24_step_round(&cube_steps[color->g], threshold);
+    const uint8_t b = rgb24_step_round(&cube_steps[color->b], threshold);
+    return 16 + r * 36 + g * 6 + b;
 }
 
 uint8_t rgb24_to_256(const struct rgb24 *color)
+{
+    // the nearest color is the nearest level of each channel,
+    // and exactly halfway between two levels rounds down
+    return rgb24_to_256_dithered(color, 129);
+}
+
+/* Nearest of xterm's default 16 colors, by squared distance, for each
+ * point of an 8x8x8 grid over the rgb cube (channel levels v * 255 / 7).
+ * Generated from the palette:
+ *
+ *   0 (0,0,0)        1 (205,0,0)      2 (0,205,0)       3 (205,205,0)
+ *   4 (0,0,238)      5 (205,0,205)    6 (0,205,205)     7 (229,229,229)
+ *   8 (127,127,127)  9 (255,0,0)     10 (0,255,0)      11 (255,255,0)
+ *  12 (92,92,255)   13 (255,0,255)   14 (0,255,255)    15 (255,255,255)
+ */
+static const uint8_t ansi_16_table[8 * 8 * 8] = {
+    /* r = 0 */
+     0,  0,  0,  0,  4,  4,  4,  4,
+     0,  0,  0,  0,  4,  4,  4,  4,
+     0,  0,  0,  0,  4,  4,  4,  4,
+     2,  2,  2,  8,  6,  6,  6, 12,
+     2,  2,  2,  6,  6,  6,  6,  6,
+     2,  2,  2,  6,  6,  6,  6,  6,
+     2,  2,  2,  6,  6,  6,  6, 14,
+    10, 10, 10,  6,  6,  6, 14, 14,
+    /* r = 1 */
+     0,  0,  0,  0,  4,  4,  4,  4,
+     0,  0,  0,  0,  4,  4,  4,  4,
+     0,  0,  0,  8,  8, 12, 12, 12,
+     2,  2,  8,  8,  8, 12, 12, 12,
+     2,  2,  2,  8,  6,  6,  6, 12,
+     2,  2,  2,  6,  6,  6,  6,  6,
+     2,  2,  2,  6,  6,  6,  6, 14,
+    10, 10, 10,  6,  6,  6, 14, 14,
+    /* r = 2 */
+     0,  0,  0,  0,  4,  4,  4,  4,
+     0,  0,  0,  8,  8, 12, 12, 12,
+     0,  0,  8,  8,  8, 12, 12, 12,
+     2,  8,  8,  8,  8, 12, 12, 12,
+     2,  2,  8,  8,  8,  8, 12, 12,
+     2,  2,  8,  8,  8,  6,  6,  6,
+     2,  2,  2,  8,  6,  6,  6, 14,
+    10, 10, 10,  6,  6,  6, 14, 14,
+    /* r = 3 */
+     1,  1,  1,  8,  5,  5,  5, 12,
+     1,  1,  8,  8,  8, 12, 12, 12,
+     1,  8,  8,  8,  8, 12, 12, 12,
+     8,  8,  8,  8,  8,  8, 12, 12,
+     3,  8,  8,  8,  8,  8, 12, 12,
+     3,  3,  8,  8,  8,  8, 12, 12,
+     3,  3,  8,  8,  8,  8,  6, 14,
+     3,  3,  3,  8,  8,  6, 14, 14,
+    /* r = 4 */
+     1,  1,  1,  5,  5,  5,  5,  5,
+     1,  1,  1,  8,  5,  5,  5, 12,
+     1,  1,  8,  8,  8,  8, 12, 12,
+     3,  8,  8,  8,  8,  8, 12, 12,
+     3,  3,  8,  8,  8,  8, 12, 12,
+     3,  3,  8,  8,  8,  8,  7,  7,
+     3,  3,  3,  8,  8,  7,  7,  7,
+     3,  3,  3,  8,  7,  7,  7,  7,
+    /* r = 5 */
+     1,  1,  1,  5,  5,  5,  5,  5,
+     1,  1,  1,  5,  5,  5,  5,  5,
+     1,  1,  8,  8,  8,  5,  5,  5,
+     3,  3,  8,  8,  8,  8, 12, 12,
+     3,  3,  8,  8,  8,  8,  7,  7,
+     3,  3,  3,  8,  8,  7,  7,  7,
+     3,  3,  3,  8,  7,  7,  7,  7,
+     3,  3,  3,  3,  7,  7,  7,  7,
+    /* r = 6 */
+     1,  1,  1,  5,  5,  5,  5, 13,
+     1,  1,  1,  5,  5,  5,  5, 13,
+     1,  1,  1,  8,  5,  5,  5, 13,
+     3,  3,  8,  8,  8,  8,  5, 13,
+     3,  3,  3,  8,  8,  7,  7,  7,
+     3,  3,  3,  8,  7,  7,  7,  7,
+     3,  3,  3,  3,  7,  7,  7,  7,
+    11, 11, 11, 11,  7,  7,  7, 15,
+    /* r = 7 */
+     9,  9,  9,  5,  5,  5, 13, 13,
+     9,  9,  9,  5,  5,  5, 13, 13,
+     9,  9,  9,  5,  5,  5, 13, 13,
+     3,  3,  3,  8,  8,  5, 13, 13,
+     3,  3,  3,  8,  7,  7,  7,  7,
+     3,  3,  3,  3,  7,  7,  7,  7,
+    11, 11, 11, 11,  7,  7,  7, 15,
+    11, 11, 11, 11,  7,  7, 15, 15,
+};
+
+uint8_t rgb24_to_16(const struct rgb24 *color)
+{
+    __ASSERT_NO_MSG(color != NULL);
+    // rounds each channel to the nearest grid level, (c * 7 + 127) / 255
+    // done as a multiply and shift
+    const uint8_t r = (color->r * 1799 + 32768) >> 16;
+    const uint8_t g = (color->g * 1799 + 32768) >> 16;
+    const uint8_t b = (color->b * 1799 + 32768) >> 16;
+    return ansi_16_table[(r << 6) | (g << 3) | b];
+}
+
+uint8_t rgb24_to_8(const struct rgb24 *color)
+{
+    __ASSERT_NO_MSG(color != NULL);
+    // the 8 ANSI colors are the corners of the rgb cube, with red,
+    // green and blue as bits 0, 1 and 2 of the color number
+    return (color->r >> 7) | ((color->g >> 7) << 1) | ((color->b >> 7) << 2);
+}
+
+/* like cube_steps, for the 8 levels (v * 255 / 7) of ansi_16_table */
+static const struct rgb24_step grid_steps[256] = {
+    {0,   0}, {0,   7}, {0,  14}, {0,  21}, {0,  28}, {0,  35}, {0,  42}, {0,  49},
+    {0,  56}, {0,  63}, {0,  70}, {0,  77}, {0,  84}, {0,  91}, {0,  98}, {0, 105},
+    {0, 112}, {0, 119}, {0, 126}, {0, 133}, {0, 140}, {0, 147}, {0, 154}, {0, 161},
+    {0, 168}, {0, 175}, {0, 182}, {0, 189}, {0, 196}, {0, 203}, {0, 210}, {0, 217},
+    {0, 224}, {0, 231}, {0, 238}, {0, 245}, {0, 252}, {1,   4}, {1,  11}, {1,  18},
+    {1,  25}, {1,  32}, {1,  39}, {1,  46}, {1,  53}, {1,  60}, {1,  67}, {1,  74},
+    {1,  81}, {1,  88}, {1,  95}, {1, 102}, {1, 109}, {1, 116}, {1, 123}, {1, 130},
+    {1, 137}, {1, 144}, {1, 151}, {1, 158}, {1, 165}, {1, 172}, {1, 179}, {1, 186},
+    {1, 193}, {1, 200}, {1, 207}, {1, 214}, {1, 221}, {1, 228}, {1, 235}, {1, 242},
+    {1, 249}, {2,   1}, {2,   8}, {2,  15}, {2,  22}, {2,  29}, {2,  36}, {2,  43},
+    {2,  50}, {2,  57}, {2,  64}, {2,  71}, {2,  78}, {2,  85}, {2,  92}, {2,  99},
+    {2, 106}, {2, 113}, {2, 120}, {2, 127}, {2, 134}, {2, 141}, {2, 148}, {2, 155},
+    {2, 162}, {2, 169}, {2, 176}, {2, 183}, {2, 190}, {2, 197}, {2, 204}, {2, 211},
+    {2, 218}, {2, 225}, {2, 232}, {2, 239}, {2, 246}, {2, 253}, {3,   5}, {3,  12},
+    {3,  19}, {3,  26}, {3,  33}, {3,  40}, {3,  47}, {3,  54}, {3,  61}, {3,  68},
+    {3,  75}, {3,  82}, {3,  89}, {3,  96}, {3, 103}, {3, 110}, {3, 117}, {3, 124},
+    {3, 131}, {3, 138}, {3, 145}, {3, 152}, {3, 159}, {3, 166}, {3, 173}, {3, 180},
+    {3, 187}, {3, 194}, {3, 201}, {3, 208}, {3, 215}, {3, 222}, {3, 229}, {3, 236},
+    {3, 243}, {3, 250}, {4,   2}, {4,   9}, {4,  16}, {4,  23}, {4,  30}, {4,  37},
+    {4,  44}, {4,  51}, {4,  58}, {4,  65}, {4,  72}, {4,  79}, {4,  86}, {4,  93},
+    {4, 100}, {4, 107}, {4, 114}, {4, 121}, {4, 128}, {4, 135}, {4, 142}, {4, 149},
+    {4, 156}, {4, 163}, {4, 170}, {4, 177}, {4, 184}, {4, 191}, {4, 198}, {4, 205},
+    {4, 212}, {4, 219}, {4, 226}, {4, 233}, {4, 240}, {4, 247}, {4, 254}, {5,   6},
+    {5,  13}, {5,  20}, {5,  27}, {5,  34}, {5,  41}, {5,  48}, {5,  55}, {5,  62},
+    {5,  69}, {5,  76}, {5,  83}, {5,  90}, {5,  97}, {5, 104}, {5, 111}, {5, 118},
+    {5, 125}, {5, 132}, {5, 139}, {5, 146}, {5, 153}, {5, 160}, {5, 167}, {5, 174},
+    {5, 181}, {5, 188}, {5, 195}, {5, 202}, {5, 209}, {5, 216}, {5, 223}, {5, 230},
+    {5, 237}, {5, 244}, {5, 251}, {6,   3}, {6,  10}, {6,  17}, {6,  24}, {6,  31},
+    {6,  38}, {6,  45}, {6,  52}, {6,  59}, {6,  66}, {6,  73}, {6,  80}, {6,  87},
+    {6,  94}, {6, 101}, {6, 108}, {6, 115}, {6, 122}, {6, 129}, {6, 136}, {6, 143},
+    {6, 150}, {6, 157}, {6, 164}, {6, 171}, {6, 178}, {6, 185}, {6, 192}, {6, 199},
+    {6, 206}, {6, 213}, {6, 220}, {6, 227}, {6, 234}, {6, 241}, {6, 248}, {7,   0},
+};
+
+uint8_t rgb24_to_16_dithered(const struct rgb24 *color, uint8_t threshold)
 {
     __ASSERT_NO_MSG(color != NULL);
+    const uint8_t r = rgb24_step_round(&grid_steps[color->r], threshold);
+    const uint8_t g = rgb24_step_round(&grid_steps[color->g], threshold);
+    const uint8_t b = rgb24_step_round(&grid_steps[color->b], threshold);
+    return ansi_16_table[(r << 6) | (g << 3) | b];
+}
 
-    uint32_t min_distance = 240;
-    uint8_t best_index = 0;
-
-    // Search through all 216 colors in the 6x6x6 cube (indices 0-215)
-    for (uint16_t i = 0; i < 216; i++)
-    {
-        uint32_t r_dist = calc_distance(color->r, i / 36);
-        uint32_t g_dist = calc_distance(color->g, (i / 6) % 6);
-        uint32_t b_dist = calc_distance(color->b, i % 6);
-
-        uint32_t total_dist = r_dist + g_dist + b_dist;
-        if (total_dist < min_distance)
-        {
-            min_distance = total_dist;
-            best_index = i;
-        }
-    }
-
-    return best_index + 16;
-}
\ No newline at end of file
+uint8_t rgb24_to_8_dithered(const struct rgb24 *color, uint8_t threshold)
+{
+    __ASSERT_NO_MSG(color != NULL);
+    // with only two levels per channel, the value is its own fraction
+    return (color->r >= threshold) | ((color->g >= threshold) << 1) | ((color->b >= threshold) << 2);
+}
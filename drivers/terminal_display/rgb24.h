@@ -18,7 +18,10 @@ struct rgb24
 };
 
 /* returns true if the colors are the same */
-bool rgb24_equal(const struct rgb24 *a, const struct rgb24 *b);
+static inline bool rgb24_equal(const struct rgb24 *a, const struct rgb24 *b)
+{
+    return a->r == b->r && a->g == b->g && a->b == b->b;
+}
 
 /* returns true if the color is grayscale */
 bool rgb24_is_grayscale(const struct rgb24 *color);
@@ -26,4 +29,36 @@ bool rgb24_is_grayscale(const struct rgb24 *color);
 /* converts to the closest 256-color code */
 uint8_t rgb24_to_256(const struct rgb24 *color);
 
+/* converts to one of the 16 ANSI colors (0-7 normal, 8-15 bright). The
+ * color is rounded to a 3-bit grid per channel and the lookup table holds
+ * the closest ANSI color of each grid point, so the result is only
+ * approximately the closest. */
+uint8_t rgb24_to_16(const struct rgb24 *color);
+
+/* converts to the closest of the 8 basic ANSI colors, taken as the
+ * corners of the rgb cube */
+uint8_t rgb24_to_8(const struct rgb24 *color);
+
+/* Ordered dithering with a 4x4 Bayer matrix. Each channel is rounded up
+ * to the next palette level if it is at least threshold 256ths of the way
+ * there, with the threshold taken from the pixel's position in the matrix.
+ * It only depends on the position, so an unchanged pixel quantizes the
+ * same every frame. */
+static inline uint8_t rgb24_dither_threshold(uint16_t x, uint16_t y)
+{
+    static const uint8_t bayer[4][4] = {
+        {8, 136, 40, 168},
+        {200, 72, 232, 104},
+        {56, 184, 24, 152},
+        {248, 120, 216, 88},
+    };
+    return bayer[y & 3][x & 3];
+}
+
+/* like rgb24_to_256(), rgb24_to_16() and rgb24_to_8(), but dithered
+ * with a threshold from rgb24_dither_threshold() */
+uint8_t rgb24_to_256_dithered(const struct rgb24 *color, uint8_t threshold);
+uint8_t rgb24_to_16_dithered(const struct rgb24 *color, uint8_t threshold);
+uint8_t rgb24_to_8_dithered(const struct rgb24 *color, uint8_t threshold);
+
 #endif // RGB24_H
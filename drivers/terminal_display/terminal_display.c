@@ -8,11 +8,15 @@
 #include <zephyr/drivers/display.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
 #include <zephyr/pm/device_runtime.h>
-#include <stdio.h>
+#include <zephyr/linker/devicetree_regions.h>
 #include <string.h>
 #include <errno.h>
+#include <terminal_display/terminal_display.h>
 #include "rgb24.h"
+#include "ansi.h"
+#include "terminal_probe.h"
 
 #define DT_DRV_COMPAT xv_terminal_display
 
@@ -22,25 +26,209 @@ struct terminal_display_config
 {
     LOG_INSTANCE_PTR_DECLARE(log);
     const struct device *terminal;
-    const struct display_capabilities capabilities;
+    struct
+    {
+        uint16_t row;
+        uint16_t column;
+    } origin;
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+    /* the devicetree resolution, which the buffers can't grow past */
+    struct
+    {
+        uint16_t width;
+        uint16_t height;
+    } max_resolution;
+#endif
+    /* color-mode is "auto", so the encoding follows the terminal probe */
+    bool auto_color_mode;
+    /* hot paths, possibly specialized for this instance */
+    int (*write)(const struct device *dev, const uint16_t x, const uint16_t y,
+                 const struct display_buffer_descriptor *desc, const void *buf);
+    void (*refresh)(const struct device *dev, struct ansi_encoder *encoder);
+#if defined(CONFIG_TERMINAL_DISPLAY_PARALLEL)
+    void (*encode)(const struct device *dev, struct ansi_encoder *encoder, size_t first, size_t last,
+                   bool redraw);
+#endif
+};
+
+/* Shared by every instance that writes to the same terminal. Serializes
+ * their escape streams and remembers what the terminal's cursor and
+ * background color currently are, so an instance picking up where
+ * another left off doesn't have to emit them again. */
+struct terminal_display_arbiter
+{
+    const struct device *terminal;
+    struct k_mutex lock;
+    atomic_t users;
+    struct ansi_state state;
+    struct
+    {
+        bool valid;
+        /* bumped on every probe, so instances notice a new result */
+        uint32_t generation;
+        enum terminal_display_color_mode color_mode;
+        uint16_t rows;
+        uint16_t columns;
+        /* the terminal is known to support REP and ECH */
+        bool rep;
+        bool ech;
+    } probe;
 };
 
 struct terminal_display_data
 {
+#if defined(CONFIG_TERMINAL_DISPLAY_RENDER_WORKQUEUE)
+    struct k_work work;
+    const struct device *dev;
+#else
     struct k_sem thread_sem;
+#endif
+    struct terminal_display_arbiter *arbiter;
+    enum terminal_display_color_mode color_mode;
+    uint32_t probe_generation;
+    atomic_t probe_requested;
+#if defined(CONFIG_PM_DEVICE)
+    atomic_t suspended;
+#endif
+    /* lives here rather than in the config, since with
+     * CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP the resolution can change */
+    struct display_capabilities capabilities;
     struct rgb24 *buffer;
     atomic_t *dirty_pixels;
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+    /* area to paint black before the next refresh, left behind by a
+     * change of resolution */
+    struct
+    {
+        uint16_t width;
+        uint16_t height;
+    } stale;
+#endif
     struct
     {
         bool on;
         bool previously_on;
     } blanking;
+#if defined(CONFIG_TERMINAL_DISPLAY_STATS)
+    struct terminal_display_stats stats;
+#endif
 };
 
-static int terminal_display_char_out(const struct device *dev, uint8_t *data, size_t length);
-static struct rgb24 *terminal_display_get_buffer_pixel(const struct device *dev, const uint16_t x, const uint16_t y);
+static int terminal_display_char_out(const struct device *dev, const uint8_t *data, size_t length);
+static void terminal_display_refresh(const struct device *dev);
+
+static struct terminal_display_arbiter arbiters[DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)];
+
+/* find the arbiter for this terminal, claiming a free one if nobody uses it yet */
+static struct terminal_display_arbiter *terminal_display_arbiter_get(const struct device *terminal)
+{
+    __ASSERT_NO_MSG(terminal != NULL);
+
+    // only called from device init, which is single threaded
+    for (size_t i = 0; i < ARRAY_SIZE(arbiters); i++)
+    {
+        if (arbiters[i].terminal == terminal)
+        {
+            return &arbiters[i];
+        }
+
+        if (arbiters[i].terminal == NULL)
+        {
+            arbiters[i].terminal = terminal;
+            k_mutex_init(&arbiters[i].lock);
+            return &arbiters[i];
+        }
+    }
+
+    // there is one arbiter per instance, so this can't happen
+    __ASSERT_NO_MSG(false);
+    return NULL;
+}
+
+static void terminal_display_arbiter_acquire(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    struct terminal_display_data *data = dev->data;
+    struct terminal_display_arbiter *arbiter = data->arbiter;
+
+    atomic_inc(&arbiter->users);
+    k_mutex_lock(&arbiter->lock, K_FOREVER);
+}
+
+static void terminal_display_arbiter_release(const struct device *dev, struct ansi_encoder *encoder)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(encoder != NULL);
+    struct terminal_display_data *data = dev->data;
+    struct terminal_display_arbiter *arbiter = data->arbiter;
+
+    // the last one out puts the terminal back to its default colors, and
+    // forgets the cursor since anything else may write to the terminal now
+    if (atomic_get(&arbiter->users) == 1)
+    {
+        ansi_reset(encoder);
+    }
+    ansi_flush(encoder);
+
+    atomic_dec(&arbiter->users);
+    k_mutex_unlock(&arbiter->lock);
+}
+
+#if defined(CONFIG_TERMINAL_DISPLAY_RENDER_WORKQUEUE)
+static K_KERNEL_STACK_DEFINE(terminal_display_workq_stack, CONFIG_TERMINAL_DISPLAY_WORKQUEUE_STACK_SIZE);
+static struct k_work_q terminal_display_workq;
+
+static void terminal_display_work_handler(struct k_work *work)
+{
+    __ASSERT_NO_MSG(work != NULL);
+    struct terminal_display_data *data = CONTAINER_OF(work, struct terminal_display_data, work);
+    terminal_display_refresh(data->dev);
+}
+
+/* started by the first instance to initialize, so it doesn't
+ * matter how the init priority relates to other SYS_INITs */
+static void terminal_display_workq_start(void)
+{
+    static bool started;
+    if (started)
+    {
+        return;
+    }
+
+    const struct k_work_queue_config workq_config = {
+        .name = "terminal_display",
+    };
+    k_work_queue_start(&terminal_display_workq, terminal_display_workq_stack,
+                       K_KERNEL_STACK_SIZEOF(terminal_display_workq_stack),
+                       CONFIG_TERMINAL_DISPLAY_WORKQUEUE_PRIORITY, &workq_config);
+    started = true;
+}
+#endif
+
+/* wake whatever renders this instance */
+static void terminal_display_schedule_refresh(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    struct terminal_display_data *data = dev->data;
+
+#if defined(CONFIG_PM_DEVICE)
+    // whatever changes while suspended is drawn on resume
+    if (atomic_get(&data->suspended))
+    {
+        return;
+    }
+#endif
+
+#if defined(CONFIG_TERMINAL_DISPLAY_RENDER_WORKQUEUE)
+    // a work item that is already queued isn't queued twice, and one that is
+    // running goes to the back of the queue, so instances take turns
+    k_work_submit_to_queue(&terminal_display_workq, &data->work);
+#else
+    k_sem_give(&data->thread_sem);
+#endif
+}
 
-static int terminal_display_char_out(const struct device *dev, uint8_t *data, size_t length)
+static int terminal_display_char_out(const struct device *dev, const uint8_t *data, size_t length)
 {
     __ASSERT_NO_MSG(dev != NULL);
     __ASSERT_NO_MSG(data != NULL);
@@ -53,6 +241,11 @@ static int terminal_display_char_out(const struct device *dev, uint8_t *data, si
         uart_poll_out(terminal, data[i]);
     }
 
+#if defined(CONFIG_TERMINAL_DISPLAY_STATS)
+    struct terminal_display_data *display_data = dev->data;
+    display_data->stats.bytes += length;
+#endif
+
     return length;
 }
 
@@ -62,7 +255,7 @@ terminal_display_blanking_on(const struct device *dev)
     __ASSERT_NO_MSG(dev != NULL);
     struct terminal_display_data *data = dev->data;
     data->blanking.on = true;
-    k_sem_give(&data->thread_sem);
+    terminal_display_schedule_refresh(dev);
     return 0;
 }
 
@@ -71,14 +264,59 @@ static int terminal_display_blanking_off(const struct device *dev)
     __ASSERT_NO_MSG(dev != NULL);
     struct terminal_display_data *data = dev->data;
     data->blanking.on = false;
-    k_sem_give(&data->thread_sem);
+    terminal_display_schedule_refresh(dev);
     return 0;
 }
 
-static int terminal_display_write(const struct device *dev, const uint16_t x,
-                                  const uint16_t y,
-                                  const struct display_buffer_descriptor *desc,
-                                  const void *buf)
+/* converts the color of the pixel at x, y to a background code (see
+ * ANSI_CODE()) in the given encoding. With CONFIG_TERMINAL_DISPLAY_DITHER
+ * the palette encodings are dithered, which depends on the position. */
+static ALWAYS_INLINE uint32_t terminal_display_background_code(const enum terminal_display_color_mode mode,
+                                                               const struct rgb24 *color, const uint16_t x,
+                                                               const uint16_t y)
+{
+#if defined(CONFIG_TERMINAL_DISPLAY_DITHER)
+    const uint8_t threshold = rgb24_dither_threshold(x, y);
+    switch (mode)
+    {
+    case TERMINAL_DISPLAY_COLOR_MODE_TRUECOLOR:
+        return ANSI_CODE(mode, ((uint32_t)color->r << 16) | ((uint32_t)color->g << 8) | color->b);
+    case TERMINAL_DISPLAY_COLOR_MODE_16:
+        return ANSI_CODE(mode, rgb24_to_16_dithered(color, threshold));
+    case TERMINAL_DISPLAY_COLOR_MODE_8:
+        return ANSI_CODE(mode, rgb24_to_8_dithered(color, threshold));
+    case TERMINAL_DISPLAY_COLOR_MODE_256:
+    default:
+        return ANSI_CODE(mode, rgb24_to_256_dithered(color, threshold));
+    }
+#else
+    ARG_UNUSED(x);
+    ARG_UNUSED(y);
+    switch (mode)
+    {
+    case TERMINAL_DISPLAY_COLOR_MODE_TRUECOLOR:
+        return ANSI_CODE(mode, ((uint32_t)color->r << 16) | ((uint32_t)color->g << 8) | color->b);
+    case TERMINAL_DISPLAY_COLOR_MODE_16:
+        return ANSI_CODE(mode, rgb24_to_16(color));
+    case TERMINAL_DISPLAY_COLOR_MODE_8:
+        return ANSI_CODE(mode, rgb24_to_8(color));
+    case TERMINAL_DISPLAY_COLOR_MODE_256:
+    default:
+        return ANSI_CODE(mode, rgb24_to_256(color));
+    }
+#endif
+}
+
+/* The write and refresh paths are implemented once here against a width and
+ * height passed in by the caller. With CONFIG_TERMINAL_DISPLAY_SPECIALIZE
+ * every instance gets its own copy with its devicetree resolution as a
+ * constant, otherwise a single generic copy reads it from the config. */
+static ALWAYS_INLINE int terminal_display_write_impl(const struct device *dev, const uint16_t x,
+                                                     const uint16_t y,
+                                                     const struct display_buffer_descriptor *desc,
+                                                     const void *buf, const uint16_t width,
+                                                     const uint16_t height,
+                                                     const enum terminal_display_color_mode mode)
 {
     __ASSERT_NO_MSG(dev != NULL);
     __ASSERT_NO_MSG(desc != NULL);
@@ -98,47 +336,108 @@ static int terminal_display_write(const struct device *dev, const uint16_t x,
     const size_t expected_size = desc->width * desc->height * sizeof(struct rgb24);
     if (desc->buf_size < expected_size)
     {
-        LOG_ERR("Buffer size is too small: %d < %d", desc->buf_size, expected_size);
+        LOG_ERR("Buffer size is too small: %u < %zu", desc->buf_size, expected_size);
         return -EINVAL;
     }
 
-    const struct rgb24 *source = (const struct rgb24 *)buf;
-    for (uint16_t sy = 0; sy < desc->height; sy++)
+    // clip once up front instead of checking every pixel
+    const uint16_t columns = x < width ? MIN(desc->width, width - x) : 0;
+    const uint16_t rows = y < height ? MIN(desc->height, height - y) : 0;
+    if (columns < desc->width || rows < desc->height)
     {
-        for (uint16_t sx = 0; sx < desc->width; sx++)
-        {
-            const struct rgb24 *color = &source[sy * desc->width + sx];
-            const uint16_t dx = x + sx;
-            const uint16_t dy = y + sy;
+        LOG_INST_WRN(config->log, "Out of bounds write: x=%d, y=%d, width=%d, height=%d",
+                     x, y, desc->width, desc->height);
+    }
+
+    for (uint16_t sy = 0; sy < rows; sy++)
+    {
+        const struct rgb24 *source = &((const struct rgb24 *)buf)[sy * desc->width];
+        const size_t offset = (size_t)(y + sy) * width + x;
+        struct rgb24 *destination = &data->buffer[offset];
+
+        // collect the dirty bits for one bitmap word at a
+        // time, so there's one atomic operation per word
+        size_t word = offset / ATOMIC_BITS;
+        atomic_val_t dirty = 0;
 
-            if (dx >= config->capabilities.x_resolution || dy >= config->capabilities.y_resolution)
+        for (uint16_t sx = 0; sx < columns; sx++)
+        {
+            const size_t index = offset + sx;
+            if (index / ATOMIC_BITS != word)
             {
-                LOG_INST_WRN(config->log, "Out of bounds pixel coordinates: x=%d, y=%d", dx, dy);
-                continue;
+                if (dirty != 0)
+                {
+                    atomic_or(&data->dirty_pixels[word], dirty);
+                }
+                word = index / ATOMIC_BITS;
+                dirty = 0;
             }
 
-            struct rgb24 *destination = terminal_display_get_buffer_pixel(dev, dx, dy);
-            if (!rgb24_equal(destination, color))
+            if (!rgb24_equal(&destination[sx], &source[sx]))
             {
-                *destination = *color;
-                atomic_set_bit(data->dirty_pixels, dy * config->capabilities.x_resolution + dx);
+#if defined(CONFIG_TERMINAL_DISPLAY_DITHER)
+                // the terminal only ever sees the encoded color, so a change
+                // that encodes the same doesn't need to be redrawn. Only
+                // checked with dithering: without it, two palette lookups
+                // per changed pixel cost the write path more than the
+                // redraws they save.
+                if (terminal_display_background_code(mode, &destination[sx], x + sx, y + sy) !=
+                    terminal_display_background_code(mode, &source[sx], x + sx, y + sy))
+                {
+                    dirty |= ATOMIC_MASK(index);
+                }
+#else
+                dirty |= ATOMIC_MASK(index);
+#endif
+                destination[sx] = source[sx];
             }
         }
+
+        if (dirty != 0)
+        {
+            atomic_or(&data->dirty_pixels[word], dirty);
+        }
     }
 
-    if (!desc->frame_incomplete)
+    if (desc->frame_incomplete)
     {
-        LOG_INST_DBG(config->log, "Complete frame");
-        k_sem_give(&data->thread_sem);
+        LOG_INST_DBG(config->log, "Partial frame");
+    }
+    else if (data->blanking.on)
+    {
+        // nothing to draw until blanking is turned off, which redraws
+        // everything anyway, so don't wake the render context for it
+        LOG_INST_DBG(config->log, "Complete frame while blanked");
     }
     else
     {
-        LOG_INST_DBG(config->log, "Partial frame");
+        LOG_INST_DBG(config->log, "Complete frame");
+        terminal_display_schedule_refresh(dev);
     }
 
     return 0;
 }
 
+static __maybe_unused int terminal_display_write_generic(const struct device *dev, const uint16_t x,
+                                                         const uint16_t y,
+                                                         const struct display_buffer_descriptor *desc,
+                                                         const void *buf)
+{
+    const struct terminal_display_data *data = dev->data;
+    return terminal_display_write_impl(dev, x, y, desc, buf, data->capabilities.x_resolution,
+                                       data->capabilities.y_resolution, data->color_mode);
+}
+
+static int terminal_display_write(const struct device *dev, const uint16_t x,
+                                  const uint16_t y,
+                                  const struct display_buffer_descriptor *desc,
+                                  const void *buf)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    const struct terminal_display_config *config = dev->config;
+    return config->write(dev, x, y, desc, buf);
+}
+
 static int terminal_display_read(const struct device *dev, const uint16_t x,
                                  const uint16_t y,
                                  const struct display_buffer_descriptor *desc,
@@ -162,59 +461,330 @@ static int terminal_display_set_contrast(const struct device *dev, const uint8_t
     return -ENOTSUP;
 }
 
-static struct rgb24 *terminal_display_get_buffer_pixel(const struct device *dev, const uint16_t x, const uint16_t y)
+/* a horizontal run of same colored pixels, waiting to be written out */
+struct terminal_display_run
+{
+    bool active;
+    uint16_t x;
+    uint16_t y;
+    uint16_t length;
+    uint32_t code;
+};
+
+/* actually write out a run of pixels to the "physical" display */
+static void terminal_display_write_run(const struct device *dev, struct ansi_encoder *encoder,
+                                       struct terminal_display_run *run)
 {
     __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(encoder != NULL);
+    __ASSERT_NO_MSG(run != NULL);
+
+    if (!run->active)
+    {
+        return;
+    }
 
     const struct terminal_display_config *config = dev->config;
+
+    // Note: each pixel is two characters wide because it looks better
+    ansi_move_cursor(encoder, config->origin.row + run->y, config->origin.column + (run->x * 2));
+    ansi_set_background(encoder, run->code);
+    ansi_fill(encoder, run->length * 2);
+
+    run->active = false;
+}
+
+/* paints the top left width x height pixels of the display black */
+static void terminal_display_paint_black(const struct device *dev, struct ansi_encoder *encoder,
+                                         const uint16_t width, const uint16_t height,
+                                         const enum terminal_display_color_mode mode)
+{
+    const struct rgb24 black = {0, 0, 0};
+
+    // one run per row
+    for (uint16_t y = 0; y < height; y++)
+    {
+        struct terminal_display_run run = {
+            .active = true,
+            .x = 0,
+            .y = y,
+            .length = width,
+            .code = terminal_display_background_code(mode, &black, 0, y),
+        };
+        terminal_display_write_run(dev, encoder, &run);
+    }
+}
+
+/* adds a pixel to the pending run, or writes the run out and starts
+ * a new one if the pixel doesn't continue it */
+static ALWAYS_INLINE void terminal_display_run_add(const struct device *dev, struct ansi_encoder *encoder,
+                                                   struct terminal_display_run *run, const uint16_t x,
+                                                   const uint16_t y, const uint32_t code,
+                                                   const uint16_t width,
+                                                   const enum terminal_display_color_mode mode)
+{
+    if (run->active && run->y == y)
+    {
+        const uint16_t end = run->x + run->length;
+        if (x == end && run->code == code)
+        {
+            run->length++;
+            return;
+        }
+
+        // redrawing a single clean pixel (two bytes, if it has the run's
+        // color) is cheaper than stepping over it with CUF (four bytes)
+        if (x == end + 1)
+        {
+            const struct terminal_display_data *data = dev->data;
+            const struct rgb24 *skipped = &data->buffer[(size_t)y * width + end];
+            if (terminal_display_background_code(mode, skipped, end, y) == run->code)
+            {
+                run->length++;
+                if (run->code == code)
+                {
+                    run->length++;
+                    return;
+                }
+            }
+        }
+    }
+
+    terminal_display_write_run(dev, encoder, run);
+
+    run->active = true;
+    run->x = x;
+    run->y = y;
+    run->length = 1;
+    run->code = code;
+}
+
+/* encodes the pixels covered by dirty bitmap words [first, last), either
+ * just the dirty ones, or all of them when redrawing */
+static ALWAYS_INLINE void terminal_display_encode_impl(const struct device *dev, struct ansi_encoder *encoder,
+                                                      const size_t first, const size_t last, const bool redraw,
+                                                      const uint16_t width, const uint16_t height,
+                                                      const enum terminal_display_color_mode mode)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(encoder != NULL);
+
+    const struct terminal_display_config *const config = dev->config;
+    struct terminal_display_data *const data = dev->data;
+    const size_t pixels = (size_t)width * height;
+    struct terminal_display_run run = {0};
+
+    // go through the dirty bitmap a word at a time. The bits are cleared
+    // before the pixels are read, so a write that lands in between is
+    // picked up next time.
+    for (size_t i = first; i < last; i++)
+    {
+        atomic_val_t dirty = atomic_clear(&data->dirty_pixels[i]);
+        if (redraw)
+        {
+            const size_t remaining = pixels - i * ATOMIC_BITS;
+            dirty = remaining >= ATOMIC_BITS ? (atomic_val_t)-1 : (atomic_val_t)BIT_MASK(remaining);
+        }
+
+        while (dirty != 0)
+        {
+            const size_t index = i * ATOMIC_BITS + __builtin_ctzl((unsigned long)dirty);
+            const uint16_t x = index % width;
+            const uint16_t y = index / width;
+            dirty &= dirty - 1;
+
+            LOG_INST_DBG(config->log, "Writing pixel at %d, %d", x, y);
+            terminal_display_run_add(dev, encoder, &run, x, y,
+                                     terminal_display_background_code(mode, &data->buffer[index], x, y),
+                                     width, mode);
+        }
+    }
+
+    terminal_display_write_run(dev, encoder, &run);
+}
+
+#if defined(CONFIG_TERMINAL_DISPLAY_PARALLEL)
+static __maybe_unused void terminal_display_encode_generic(const struct device *dev,
+                                                           struct ansi_encoder *encoder, size_t first,
+                                                           size_t last, bool redraw)
+{
     const struct terminal_display_data *data = dev->data;
+    terminal_display_encode_impl(dev, encoder, first, last, redraw, data->capabilities.x_resolution,
+                                 data->capabilities.y_resolution, data->color_mode);
+}
+
+/* A range of the dirty bitmap, encoded by a worker thread into its own
+ * buffer while the render context writes the bands before it out */
+struct terminal_display_band
+{
+    /* given by the render context when the band is set up */
+    struct k_sem start;
+    /* given by the worker when the buffer is full, or the band is done */
+    struct k_sem ready;
+    /* given by the render context once a full buffer is written out */
+    struct k_sem drained;
+    const struct device *dev;
+    size_t first;
+    size_t last;
+    bool redraw;
+    uint16_t columns;
+    bool rep;
+    bool ech;
+    bool done;
+    /* the band starts out knowing nothing about the terminal, so its
+     * output doesn't depend on what the bands before it leave behind */
+    struct ansi_state state;
+    size_t length;
+    uint8_t buffer[CONFIG_TERMINAL_DISPLAY_PARALLEL_BUFFER_SIZE];
+};
+
+BUILD_ASSERT(CONFIG_TERMINAL_DISPLAY_PARALLEL_BUFFER_SIZE >= SIZEOF_FIELD(struct ansi_encoder, buffer),
+             "a band buffer must hold at least one chunk of encoder output");
+
+static K_KERNEL_STACK_ARRAY_DEFINE(terminal_display_band_stacks, CONFIG_TERMINAL_DISPLAY_PARALLEL_WORKERS,
+                                   CONFIG_TERMINAL_DISPLAY_PARALLEL_STACK_SIZE);
+static struct k_thread terminal_display_band_threads[CONFIG_TERMINAL_DISPLAY_PARALLEL_WORKERS];
+static struct terminal_display_band terminal_display_bands[CONFIG_TERMINAL_DISPLAY_PARALLEL_WORKERS];
+/* the workers are shared by all instances */
+static K_MUTEX_DEFINE(terminal_display_bands_lock);
 
-    __ASSERT_NO_MSG(x < config->capabilities.x_resolution);
-    __ASSERT_NO_MSG(y < config->capabilities.y_resolution);
+static void terminal_display_band_sink(void *user_data, const uint8_t *data, size_t length)
+{
+    __ASSERT_NO_MSG(user_data != NULL);
+    struct terminal_display_band *band = user_data;
+
+    if (band->length + length > sizeof(band->buffer))
+    {
+        // wait for the render context to get to this band and write it out
+        k_sem_give(&band->ready);
+        k_sem_take(&band->drained, K_FOREVER);
+    }
 
-    return &data->buffer[y * config->capabilities.x_resolution + x];
+    memcpy(&band->buffer[band->length], data, length);
+    band->length += length;
 }
 
-/* actually write out a value to the "physical" display */
-static void terminal_display_write_pixel(const struct device *dev, const uint16_t x, const uint16_t y, const struct rgb24 *color)
+static void terminal_display_band_entry(void *b, void *p2, void *p3)
+{
+    __ASSERT_NO_MSG(b != NULL);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    struct terminal_display_band *band = b;
+
+    while (true)
+    {
+        k_sem_take(&band->start, K_FOREVER);
+
+        const struct terminal_display_config *config = band->dev->config;
+        struct ansi_encoder encoder;
+        band->state = (struct ansi_state){0};
+        ansi_encoder_init(&encoder, &band->state, terminal_display_band_sink, band, band->columns);
+        encoder.rep = band->rep;
+        encoder.ech = band->ech;
+
+        config->encode(band->dev, &encoder, band->first, band->last, band->redraw);
+        ansi_flush(&encoder);
+
+        band->done = true;
+        k_sem_give(&band->ready);
+    }
+}
+
+/* started by the first instance to initialize */
+static void terminal_display_bands_start(void)
+{
+    static bool started;
+    if (started)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(terminal_display_bands); i++)
+    {
+        struct terminal_display_band *band = &terminal_display_bands[i];
+        k_sem_init(&band->start, 0, 1);
+        k_sem_init(&band->ready, 0, 1);
+        k_sem_init(&band->drained, 0, 1);
+        k_thread_create(&terminal_display_band_threads[i], terminal_display_band_stacks[i],
+                        K_KERNEL_STACK_SIZEOF(terminal_display_band_stacks[i]), terminal_display_band_entry,
+                        band, NULL, NULL, CONFIG_TERMINAL_DISPLAY_PARALLEL_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&terminal_display_band_threads[i], "terminal_display_band");
+    }
+    started = true;
+}
+
+/* Splits the words of the dirty bitmap into one band per worker plus one
+ * for the render context. The render context encodes the first band
+ * straight to the terminal while the workers encode the others, then
+ * writes those out in order. */
+static void terminal_display_encode_parallel(const struct device *dev, struct ansi_encoder *encoder,
+                                             const size_t words, const bool redraw)
 {
     __ASSERT_NO_MSG(dev != NULL);
-    __ASSERT_NO_MSG(color != NULL);
+    __ASSERT_NO_MSG(encoder != NULL);
 
     const struct terminal_display_config *config = dev->config;
-    if (x >= config->capabilities.x_resolution || y >= config->capabilities.y_resolution)
+    const size_t bands = ARRAY_SIZE(terminal_display_bands) + 1;
+
+    k_mutex_lock(&terminal_display_bands_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ARRAY_SIZE(terminal_display_bands); i++)
     {
-        LOG_ERR("Invalid pixel coordinates: x=%d, y=%d", x, y);
-        return;
+        struct terminal_display_band *band = &terminal_display_bands[i];
+        band->dev = dev;
+        band->first = (i + 1) * words / bands;
+        band->last = (i + 2) * words / bands;
+        band->redraw = redraw;
+        band->columns = encoder->columns;
+        band->rep = encoder->rep;
+        band->ech = encoder->ech;
+        band->done = false;
+        band->length = 0;
+        k_sem_give(&band->start);
     }
 
-    // first, convert the rgb24 color to a 256 color index
-    const uint8_t color_index = rgb24_to_256(color);
-    // navigate the cursor to that position within the terminal
-    // using the "cursor position" escape sequence
-    // Format and send the cursor position escape sequence
-    char cursor_pos[32];
-    // Note: Terminal coordinates are 1-based
-    // Note: each pixel is two characters wide because it looks better
-    snprintf(cursor_pos, sizeof(cursor_pos), "\x1b[%d;%dH", y + 1, (x * 2) + 1);
-    terminal_display_char_out(dev, (uint8_t *)cursor_pos, strlen(cursor_pos));
+    config->encode(dev, encoder, 0, words / bands, redraw);
+    ansi_flush(encoder);
 
-    // Set the background color using the 256-color index
-    // Note: each pixel is two characters wide because it looks better
-    char color_cmd[32];
-    snprintf(color_cmd, sizeof(color_cmd), "\x1b[48;5;%dm  ", color_index);
-    terminal_display_char_out(dev, (uint8_t *)color_cmd, strlen(color_cmd));
+    for (size_t i = 0; i < ARRAY_SIZE(terminal_display_bands); i++)
+    {
+        struct terminal_display_band *band = &terminal_display_bands[i];
+        bool written = false;
+        bool done;
 
-    // Reset colors
-    const char *reset = "\x1b[0m";
-    terminal_display_char_out(dev, (uint8_t *)reset, strlen(reset));
+        do
+        {
+            k_sem_take(&band->ready, K_FOREVER);
+            done = band->done;
+            if (band->length > 0)
+            {
+                terminal_display_char_out(dev, band->buffer, band->length);
+                band->length = 0;
+                written = true;
+            }
+            if (!done)
+            {
+                k_sem_give(&band->drained);
+            }
+        } while (!done);
+
+        // the terminal is now in whatever state the band left it
+        if (written)
+        {
+            *encoder->state = band->state;
+        }
+    }
+
+    k_mutex_unlock(&terminal_display_bands_lock);
 }
+#endif
 
 static void terminal_display_get_capabilities(const struct device *dev,
                                               struct display_capabilities *capabilities)
 {
-    const struct terminal_display_config *config = dev->config;
-    *capabilities = config->capabilities;
+    const struct terminal_display_data *data = dev->data;
+    *capabilities = data->capabilities;
 }
 
 static int terminal_display_write_pixel_format(const struct device *dev,
@@ -254,6 +824,206 @@ static DEVICE_API(display, api) = {
     .set_orientation = terminal_display_set_orientation,
 };
 
+#if defined(CONFIG_TERMINAL_DISPLAY_STATS)
+int terminal_display_get_stats(const struct device *dev, struct terminal_display_stats *stats)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(stats != NULL);
+
+    if (dev->api != &api)
+    {
+        return -EINVAL;
+    }
+
+    const struct terminal_display_data *data = dev->data;
+    *stats = data->stats;
+    return 0;
+}
+#endif
+
+int terminal_display_probe(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+    if (dev->api != &api)
+    {
+        return -EINVAL;
+    }
+
+    struct terminal_display_data *data = dev->data;
+    atomic_set(&data->probe_requested, 1);
+    terminal_display_schedule_refresh(dev);
+    return 0;
+}
+
+int terminal_display_get_terminal_info(const struct device *dev,
+                                       struct terminal_display_terminal_info *info)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(info != NULL);
+
+    if (dev->api != &api)
+    {
+        return -EINVAL;
+    }
+
+    struct terminal_display_data *data = dev->data;
+    struct terminal_display_arbiter *arbiter = data->arbiter;
+
+    k_mutex_lock(&arbiter->lock, K_FOREVER);
+    info->color_mode = data->color_mode;
+    info->rows = arbiter->probe.valid ? arbiter->probe.rows : 0;
+    info->columns = arbiter->probe.valid ? arbiter->probe.columns : 0;
+    k_mutex_unlock(&arbiter->lock);
+
+    return 0;
+}
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_CUSTOM_SECTION)
+#define TERMINAL_DISPLAY_BUFFER_SECTION Z_GENERIC_SECTION(.terminal_display_buf)
+#else
+#define TERMINAL_DISPLAY_BUFFER_SECTION
+#endif
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+/* sys_heap rounds each allocation up to 8 byte chunks and puts a chunk
+ * header in front of it */
+#define TERMINAL_DISPLAY_HEAP_CHUNK(bytes) (ROUND_UP(bytes, 8) + 8)
+
+/* an instance's buffers at its devicetree resolution, twice over since
+ * the old and new ones exist side by side while the resolution changes */
+#define TERMINAL_DISPLAY_HEAP_INST_SIZE(inst)                                                              \
+    (2 * (TERMINAL_DISPLAY_HEAP_CHUNK(DT_INST_PROP(inst, width) * DT_INST_PROP(inst, height) *            \
+                                      sizeof(struct rgb24)) +                                              \
+          TERMINAL_DISPLAY_HEAP_CHUNK(ATOMIC_BITMAP_SIZE(DT_INST_PROP(inst, width) *                       \
+                                                         DT_INST_PROP(inst, height)) *                     \
+                                      sizeof(atomic_t)))) +
+
+/* the heap's own header and free lists, generously */
+#define TERMINAL_DISPLAY_HEAP_OVERHEAD 256
+
+#define TERMINAL_DISPLAY_HEAP_SIZE                                                                         \
+    (DT_INST_FOREACH_STATUS_OKAY(TERMINAL_DISPLAY_HEAP_INST_SIZE) TERMINAL_DISPLAY_HEAP_OVERHEAD +         \
+     CONFIG_TERMINAL_DISPLAY_HEAP_SIZE)
+
+static uint8_t terminal_display_heap_memory[TERMINAL_DISPLAY_HEAP_SIZE]
+    __aligned(sizeof(atomic_t)) TERMINAL_DISPLAY_BUFFER_SECTION;
+static struct k_heap terminal_display_heap;
+
+/* set up by the first instance to initialize */
+static void terminal_display_heap_init(void)
+{
+    static bool initialized;
+    if (initialized)
+    {
+        return;
+    }
+
+    k_heap_init(&terminal_display_heap, terminal_display_heap_memory,
+                sizeof(terminal_display_heap_memory));
+    initialized = true;
+}
+
+/* Replaces the buffers with blank ones for the given resolution. The new
+ * ones are allocated before the old ones are freed, so a failure leaves
+ * the display as it was. */
+static int terminal_display_buffers_alloc(const struct device *dev, const uint16_t width,
+                                          const uint16_t height)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    struct terminal_display_data *data = dev->data;
+
+    const size_t pixels = (size_t)width * height;
+    const size_t dirty_size = ATOMIC_BITMAP_SIZE(pixels) * sizeof(atomic_t);
+    struct rgb24 *buffer = k_heap_alloc(&terminal_display_heap, pixels * sizeof(struct rgb24), K_NO_WAIT);
+    atomic_t *dirty_pixels = k_heap_alloc(&terminal_display_heap, dirty_size, K_NO_WAIT);
+    if (buffer == NULL || dirty_pixels == NULL)
+    {
+        k_heap_free(&terminal_display_heap, buffer);
+        k_heap_free(&terminal_display_heap, dirty_pixels);
+        return -ENOMEM;
+    }
+
+    memset(buffer, 0, pixels * sizeof(struct rgb24));
+    memset(dirty_pixels, 0, dirty_size);
+
+    k_heap_free(&terminal_display_heap, data->buffer);
+    k_heap_free(&terminal_display_heap, data->dirty_pixels);
+    data->buffer = buffer;
+    data->dirty_pixels = dirty_pixels;
+    data->capabilities.x_resolution = width;
+    data->capabilities.y_resolution = height;
+
+    return 0;
+}
+#endif
+
+static int terminal_display_buffers_init(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+    const struct terminal_display_config *config = dev->config;
+    terminal_display_heap_init();
+    return terminal_display_buffers_alloc(dev, config->max_resolution.width,
+                                          config->max_resolution.height);
+#else
+    // buffers placed outside of .bss aren't zeroed at startup
+    struct terminal_display_data *data = dev->data;
+    const size_t pixels = (size_t)data->capabilities.x_resolution * data->capabilities.y_resolution;
+    memset(data->buffer, 0, pixels * sizeof(struct rgb24));
+    memset(data->dirty_pixels, 0, ATOMIC_BITMAP_SIZE(pixels) * sizeof(atomic_t));
+    return 0;
+#endif
+}
+
+int terminal_display_set_resolution(const struct device *dev, uint16_t width, uint16_t height)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+    if (dev->api != &api)
+    {
+        return -EINVAL;
+    }
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+    const struct terminal_display_config *config = dev->config;
+    struct terminal_display_data *data = dev->data;
+    struct terminal_display_arbiter *arbiter = data->arbiter;
+
+    if (width == 0 || height == 0 || width > config->max_resolution.width ||
+        height > config->max_resolution.height)
+    {
+        return -EINVAL;
+    }
+
+    // the render context only touches the buffers with the arbiter held
+    k_mutex_lock(&arbiter->lock, K_FOREVER);
+    const uint16_t previous_width = data->capabilities.x_resolution;
+    const uint16_t previous_height = data->capabilities.y_resolution;
+    const int ret = terminal_display_buffers_alloc(dev, width, height);
+    if (ret == 0)
+    {
+        // the new buffer is black, so painting over both the old and the
+        // new area leaves nothing for the refresh to redraw
+        data->stale.width = MAX(data->stale.width, MAX(previous_width, width));
+        data->stale.height = MAX(data->stale.height, MAX(previous_height, height));
+    }
+    k_mutex_unlock(&arbiter->lock);
+
+    if (ret < 0)
+    {
+        LOG_INST_ERR(config->log, "Failed to allocate buffers for %dx%d", width, height);
+        return ret;
+    }
+
+    terminal_display_schedule_refresh(dev);
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
 static int terminal_display_init(const struct device *dev)
 {
     const struct terminal_display_config *config = dev->config;
@@ -265,13 +1035,297 @@ static int terminal_display_init(const struct device *dev)
         return -ENODEV;
     }
 
-    // giving the sem will let the thread
-    // build up the blank screen to start
-    k_sem_give(&data->thread_sem);
+    data->arbiter = terminal_display_arbiter_get(config->terminal);
+
+    const int ret = terminal_display_buffers_init(dev);
+    if (ret < 0)
+    {
+        LOG_INST_ERR(config->log, "Failed to set up buffers (%d)", ret);
+        return ret;
+    }
+
+#if defined(CONFIG_TERMINAL_DISPLAY_RENDER_WORKQUEUE)
+    terminal_display_workq_start();
+#endif
+#if defined(CONFIG_TERMINAL_DISPLAY_PARALLEL)
+    terminal_display_bands_start();
+#endif
+
+    // scheduling a refresh will build up
+    // the blank screen to start
+    terminal_display_schedule_refresh(dev);
 
     return 0;
 }
 
+#if defined(CONFIG_PM_DEVICE)
+static int terminal_display_pm_action(const struct device *dev, enum pm_device_action action)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    struct terminal_display_data *data = dev->data;
+
+    switch (action)
+    {
+    case PM_DEVICE_ACTION_SUSPEND:
+        // a refresh that is already under way finishes,
+        // but the render context isn't woken again
+        atomic_set(&data->suspended, 1);
+        return 0;
+    case PM_DEVICE_ACTION_RESUME:
+        atomic_set(&data->suspended, 0);
+        // catch up on anything written while suspended
+        terminal_display_schedule_refresh(dev);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+#endif
+
+static ALWAYS_INLINE void terminal_display_refresh_impl(const struct device *dev,
+                                                       struct ansi_encoder *encoder,
+                                                       const uint16_t width, const uint16_t height,
+                                                       const enum terminal_display_color_mode mode)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(encoder != NULL);
+
+    const struct terminal_display_config *const config = dev->config;
+    struct terminal_display_data *const data = dev->data;
+    const size_t words = ATOMIC_BITMAP_SIZE((size_t)width * height);
+
+    // If blanking is on, and it wasn't previously on,
+    // clear the whole display by setting the color to black.
+    if (data->blanking.on && !data->blanking.previously_on)
+    {
+        LOG_INST_INF(config->log, "Blanking terminal_display - blanking on");
+        terminal_display_paint_black(dev, encoder, width, height, mode);
+    }
+    else if (!data->blanking.on)
+    {
+        // coming back from blanking redraws everything,
+        // otherwise just the pixels that changed
+        const bool redraw = data->blanking.previously_on;
+        if (redraw)
+        {
+            LOG_INST_INF(config->log, "Restoring terminal_display - blanking off");
+        }
+
+#if defined(CONFIG_TERMINAL_DISPLAY_PARALLEL)
+        terminal_display_encode_parallel(dev, encoder, words, redraw);
+#else
+        terminal_display_encode_impl(dev, encoder, 0, words, redraw, width, height, mode);
+#endif
+    }
+
+    data->blanking.previously_on = data->blanking.on;
+}
+
+static __maybe_unused void terminal_display_refresh_generic(const struct device *dev,
+                                                            struct ansi_encoder *encoder)
+{
+    const struct terminal_display_data *data = dev->data;
+    terminal_display_refresh_impl(dev, encoder, data->capabilities.x_resolution,
+                                  data->capabilities.y_resolution, data->color_mode);
+}
+
+static void terminal_display_mark_all_dirty(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+    struct terminal_display_data *data = dev->data;
+    const size_t pixels = (size_t)data->capabilities.x_resolution * data->capabilities.y_resolution;
+
+    for (size_t i = 0; i < pixels / ATOMIC_BITS; i++)
+    {
+        atomic_set(&data->dirty_pixels[i], (atomic_val_t)-1);
+    }
+
+    // don't mark anything past the last pixel
+    if (pixels % ATOMIC_BITS != 0)
+    {
+        atomic_or(&data->dirty_pixels[pixels / ATOMIC_BITS], BIT_MASK(pixels % ATOMIC_BITS));
+    }
+}
+
+/* runs with the arbiter held, since the replies and this instance's
+ * output come and go over the same uart as the other viewports' */
+static void terminal_display_probe_terminal(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+    const struct terminal_display_config *config = dev->config;
+    struct terminal_display_data *data = dev->data;
+    struct terminal_display_arbiter *arbiter = data->arbiter;
+
+    struct terminal_probe_result result;
+    const int ret = terminal_probe(config->terminal, K_MSEC(CONFIG_TERMINAL_DISPLAY_PROBE_TIMEOUT_MS), &result);
+
+    // the probe moves the cursor around, and the replies
+    // may have been echoed if nothing understood them
+    arbiter->state.cursor.valid = false;
+
+    arbiter->probe.valid = true;
+    arbiter->probe.generation++;
+    arbiter->probe.rows = result.rows;
+    arbiter->probe.columns = result.columns;
+    // REP is an ECMA-48 extra that xterm and its descendants implement,
+    // but DEC terminals of any level and VT102 emulators like minicom
+    // don't, so only answering XTGETTCAP counts. ECH arrived with the
+    // VT220.
+    arbiter->probe.rep = result.xterm;
+    arbiter->probe.ech = result.xterm || result.conformance >= 62;
+
+    if (ret < 0)
+    {
+        LOG_INST_WRN(config->log, "Terminal didn't answer the probe (%d), assuming 256 colors", ret);
+        arbiter->probe.color_mode = TERMINAL_DISPLAY_COLOR_MODE_256;
+        return;
+    }
+
+    if (result.truecolor || result.colors >= (1 << 24))
+    {
+        arbiter->probe.color_mode = TERMINAL_DISPLAY_COLOR_MODE_TRUECOLOR;
+    }
+    else if (result.colors == 0 || result.colors >= 256)
+    {
+        // nothing advertised, but the terminal answered, so it's at
+        // least a VT100 descendant. This is what the driver always assumed.
+        arbiter->probe.color_mode = TERMINAL_DISPLAY_COLOR_MODE_256;
+    }
+    else if (result.colors >= 16)
+    {
+        arbiter->probe.color_mode = TERMINAL_DISPLAY_COLOR_MODE_16;
+    }
+    else
+    {
+        arbiter->probe.color_mode = TERMINAL_DISPLAY_COLOR_MODE_8;
+    }
+
+    LOG_INST_INF(config->log, "Terminal is %dx%d, color mode %d", result.columns, result.rows,
+                 arbiter->probe.color_mode);
+
+    if (result.rows != 0 && result.columns != 0 &&
+        (config->origin.row + data->capabilities.y_resolution > result.rows ||
+         config->origin.column + data->capabilities.x_resolution * 2 > result.columns))
+    {
+        LOG_INST_WRN(config->log, "Display doesn't fit in the %dx%d terminal", result.columns,
+                     result.rows);
+    }
+}
+
+static void terminal_display_sink(void *user_data, const uint8_t *data, size_t length)
+{
+    terminal_display_char_out(user_data, data, length);
+}
+
+/* keeps the terminal resumed for the duration of a refresh */
+static int terminal_display_terminal_get(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+#if defined(CONFIG_TERMINAL_DISPLAY_PM)
+    const struct terminal_display_config *config = dev->config;
+
+#if defined(CONFIG_TERMINAL_DISPLAY_STATS)
+    struct terminal_display_data *data = dev->data;
+    enum pm_device_state state;
+    if (pm_device_state_get(config->terminal, &state) == 0 && state == PM_DEVICE_STATE_SUSPENDED)
+    {
+        data->stats.terminal_resumes++;
+    }
+#endif
+
+    return pm_device_runtime_get(config->terminal);
+#else
+    ARG_UNUSED(dev);
+    return 0;
+#endif
+}
+
+/* lets the terminal suspend once the autosuspend delay passes without
+ * another refresh. The delay also covers the last bytes written, which
+ * may still be on their way out of the uart. */
+static void terminal_display_terminal_put(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+#if defined(CONFIG_TERMINAL_DISPLAY_PM)
+    const struct terminal_display_config *config = dev->config;
+    pm_device_runtime_put_async(config->terminal, K_MSEC(CONFIG_TERMINAL_DISPLAY_PM_AUTOSUSPEND_MS));
+#else
+    ARG_UNUSED(dev);
+#endif
+}
+
+static void terminal_display_refresh(const struct device *dev)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+
+    const struct terminal_display_config *config = dev->config;
+    struct terminal_display_data *data = dev->data;
+    struct terminal_display_arbiter *arbiter = data->arbiter;
+
+    // the dirty bits stay set, so nothing is lost if this fails
+    const int ret = terminal_display_terminal_get(dev);
+    if (ret < 0)
+    {
+        LOG_INST_ERR(config->log, "Failed to resume the terminal (%d)", ret);
+        return;
+    }
+
+    terminal_display_arbiter_acquire(dev);
+
+    // probe if asked to, or if this instance needs a result and
+    // nobody else sharing the terminal has probed it yet
+    if (atomic_clear(&data->probe_requested) || (config->auto_color_mode && !arbiter->probe.valid))
+    {
+        terminal_display_probe_terminal(dev);
+    }
+
+    // follow the terminal's encoding, and redraw everything in it
+    if (config->auto_color_mode && arbiter->probe.valid &&
+        data->probe_generation != arbiter->probe.generation)
+    {
+        data->probe_generation = arbiter->probe.generation;
+        if (data->color_mode != arbiter->probe.color_mode)
+        {
+            data->color_mode = arbiter->probe.color_mode;
+            terminal_display_mark_all_dirty(dev);
+        }
+    }
+
+    // the cursor position is only trusted left of the terminal's right
+    // edge. If the terminal's width is unknown, assume this display's
+    // right edge might be it.
+    struct ansi_encoder encoder;
+    const uint16_t columns = arbiter->probe.valid && arbiter->probe.columns != 0
+                                 ? arbiter->probe.columns
+                                 : config->origin.column + data->capabilities.x_resolution * 2;
+    ansi_encoder_init(&encoder, &arbiter->state, terminal_display_sink, (void *)dev, columns);
+    encoder.rep = IS_ENABLED(CONFIG_TERMINAL_DISPLAY_FILL_REP) || (arbiter->probe.valid && arbiter->probe.rep);
+    encoder.ech = IS_ENABLED(CONFIG_TERMINAL_DISPLAY_FILL_ECH) || (arbiter->probe.valid && arbiter->probe.ech);
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+    if (data->stale.width != 0)
+    {
+        terminal_display_paint_black(dev, &encoder, data->stale.width, data->stale.height, data->color_mode);
+        data->stale.width = 0;
+        data->stale.height = 0;
+    }
+#endif
+
+    config->refresh(dev, &encoder);
+
+    terminal_display_arbiter_release(dev, &encoder);
+    terminal_display_terminal_put(dev);
+
+#if defined(CONFIG_TERMINAL_DISPLAY_STATS)
+    data->stats.frames++;
+#endif
+}
+
+#if defined(CONFIG_TERMINAL_DISPLAY_RENDER_THREAD)
 static void terminal_display_thread_entry(void *d, void *p2, void *p3)
 {
     __ASSERT_NO_MSG(d != NULL);
@@ -288,67 +1342,139 @@ static void terminal_display_thread_entry(void *d, void *p2, void *p3)
         k_sem_take(&data->thread_sem, K_FOREVER);
         LOG_INST_DBG(config->log, "Semaphore taken");
 
-        // If blanking is on, and it wasn't previously on,
-        // clear the whole display by setting the color to black.
-        if (data->blanking.on && !data->blanking.previously_on)
-        {
-            LOG_INST_INF(config->log, "Blanking terminal_display - blanking on");
-            const struct rgb24 black = {0, 0, 0};
-            // clear the whole display
-            for (uint16_t y = 0; y < config->capabilities.y_resolution; y++)
-            {
-                for (uint16_t x = 0; x < config->capabilities.x_resolution; x++)
-                {
-                    terminal_display_write_pixel(dev, x, y, &black);
-                }
-            }
-        }
-        else if (!data->blanking.on && data->blanking.previously_on)
-        {
-            LOG_INST_INF(config->log, "Restoring terminal_display - blanking off");
-            for (uint16_t y = 0; y < config->capabilities.y_resolution; y++)
-            {
-                for (uint16_t x = 0; x < config->capabilities.x_resolution; x++)
-                {
-                    const struct rgb24 *color = terminal_display_get_buffer_pixel(dev, x, y);
-                    terminal_display_write_pixel(dev, x, y, color);
-                    // clear all of the dirty bits
-                    atomic_clear_bit(data->dirty_pixels, y * config->capabilities.x_resolution + x);
-                }
-            }
-        }
-        else
-        {
-            // normal write - go through the whole display and write every
-            // dirty bit out do the display
-            for (uint16_t y = 0; y < config->capabilities.y_resolution; y++)
-            {
-                for (uint16_t x = 0; x < config->capabilities.x_resolution; x++)
-                {
-                    if (atomic_test_and_clear_bit(data->dirty_pixels, y * config->capabilities.x_resolution + x))
-                    {
-                        LOG_INST_DBG(config->log, "Writing pixel at %d, %d", x, y);
-                        const struct rgb24 *color = terminal_display_get_buffer_pixel(dev, x, y);
-                        terminal_display_write_pixel(dev, x, y, color);
-                    }
-                }
-            }
-        }
-
-        data->blanking.previously_on = data->blanking.on;
+        terminal_display_refresh(dev);
     }
 }
 
+#define TERMINAL_DISPLAY_THREAD_DEFINE(inst)                                                         \
+    K_KERNEL_THREAD_DEFINE(terminal_display_thread##inst, CONFIG_TERMINAL_DISPLAY_THREAD_STACK_SIZE, \
+                           terminal_display_thread_entry, DEVICE_DT_INST_GET(inst), NULL, NULL,      \
+                           CONFIG_TERMINAL_DISPLAY_THREAD_PRIORITY, 0, 0);
+#define TERMINAL_DISPLAY_RENDER_DATA_INIT(inst) \
+    .thread_sem = Z_SEM_INITIALIZER(data##inst.thread_sem, 0, 1),
+#else
+#define TERMINAL_DISPLAY_THREAD_DEFINE(inst)
+#define TERMINAL_DISPLAY_RENDER_DATA_INIT(inst)                    \
+    .work = Z_WORK_INITIALIZER(terminal_display_work_handler), \
+    .dev = DEVICE_DT_INST_GET(inst),
+#endif
+
+/* the color-mode enum lists the modes in the same order as
+ * enum terminal_display_color_mode, with "auto" last */
+#define TERMINAL_DISPLAY_AUTO_COLOR_MODE(inst) DT_INST_ENUM_HAS_VALUE(inst, color_mode, auto)
+#define TERMINAL_DISPLAY_DT_COLOR_MODE(inst)                                  \
+    (TERMINAL_DISPLAY_AUTO_COLOR_MODE(inst) ? TERMINAL_DISPLAY_COLOR_MODE_256 \
+                                            : (enum terminal_display_color_mode)DT_INST_ENUM_IDX(inst, color_mode))
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+/* the resolution is only known at runtime, so only the color mode is specialized */
+#define TERMINAL_DISPLAY_WIDTH(inst, dev) \
+    (((const struct terminal_display_data *)(dev)->data)->capabilities.x_resolution)
+#define TERMINAL_DISPLAY_HEIGHT(inst, dev) \
+    (((const struct terminal_display_data *)(dev)->data)->capabilities.y_resolution)
+#else
+#define TERMINAL_DISPLAY_WIDTH(inst, dev) DT_INST_PROP(inst, width)
+#define TERMINAL_DISPLAY_HEIGHT(inst, dev) DT_INST_PROP(inst, height)
+#endif
+
+/* the color mode is only known at runtime with color-mode "auto" */
+#define TERMINAL_DISPLAY_MODE(inst, dev)                                                 \
+    (TERMINAL_DISPLAY_AUTO_COLOR_MODE(inst)                                              \
+         ? ((const struct terminal_display_data *)(dev)->data)->color_mode               \
+         : TERMINAL_DISPLAY_DT_COLOR_MODE(inst))
+
+#if defined(CONFIG_TERMINAL_DISPLAY_SPECIALIZE)
+#define TERMINAL_DISPLAY_SPECIALIZE(inst)                                                                         \
+    static int terminal_display_write_##inst(const struct device *dev, const uint16_t x, const uint16_t y,        \
+                                             const struct display_buffer_descriptor *desc, const void *buf)       \
+    {                                                                                                             \
+        return terminal_display_write_impl(dev, x, y, desc, buf, TERMINAL_DISPLAY_WIDTH(inst, dev),               \
+                                           TERMINAL_DISPLAY_HEIGHT(inst, dev), TERMINAL_DISPLAY_MODE(inst, dev)); \
+    }                                                                                                             \
+    static void terminal_display_refresh_##inst(const struct device *dev, struct ansi_encoder *encoder)           \
+    {                                                                                                             \
+        terminal_display_refresh_impl(dev, encoder, TERMINAL_DISPLAY_WIDTH(inst, dev),                            \
+                                      TERMINAL_DISPLAY_HEIGHT(inst, dev), TERMINAL_DISPLAY_MODE(inst, dev));      \
+    }
+#define TERMINAL_DISPLAY_WRITE_FN(inst) terminal_display_write_##inst
+#define TERMINAL_DISPLAY_REFRESH_FN(inst) terminal_display_refresh_##inst
+#else
+#define TERMINAL_DISPLAY_SPECIALIZE(inst)
+#define TERMINAL_DISPLAY_WRITE_FN(inst) terminal_display_write_generic
+#define TERMINAL_DISPLAY_REFRESH_FN(inst) terminal_display_refresh_generic
+#endif
+
+/* the bands are encoded through the config, so the workers
+ * can run the specialized loop of whichever instance they encode */
+#if defined(CONFIG_TERMINAL_DISPLAY_PARALLEL) && defined(CONFIG_TERMINAL_DISPLAY_SPECIALIZE)
+#define TERMINAL_DISPLAY_SPECIALIZE_ENCODE(inst)                                                                  \
+    static void terminal_display_encode_##inst(const struct device *dev, struct ansi_encoder *encoder,            \
+                                               size_t first, size_t last, bool redraw)                           \
+    {                                                                                                             \
+        terminal_display_encode_impl(dev, encoder, first, last, redraw, TERMINAL_DISPLAY_WIDTH(inst, dev),        \
+                                     TERMINAL_DISPLAY_HEIGHT(inst, dev), TERMINAL_DISPLAY_MODE(inst, dev));       \
+    }
+#define TERMINAL_DISPLAY_ENCODE_INIT(inst) .encode = terminal_display_encode_##inst,
+#elif defined(CONFIG_TERMINAL_DISPLAY_PARALLEL)
+#define TERMINAL_DISPLAY_SPECIALIZE_ENCODE(inst)
+#define TERMINAL_DISPLAY_ENCODE_INIT(inst) .encode = terminal_display_encode_generic,
+#else
+#define TERMINAL_DISPLAY_SPECIALIZE_ENCODE(inst)
+#define TERMINAL_DISPLAY_ENCODE_INIT(inst)
+#endif
+
 #define TERMINAL_DISPLAY_BUFFER_SIZE(inst) (DT_INST_PROP(inst, width) * DT_INST_PROP(inst, height))
 
+/* an instance's memory-region takes precedence over the Kconfig section */
+#define TERMINAL_DISPLAY_INST_BUFFER_SECTION(inst)                                                     \
+    COND_CODE_1(DT_INST_NODE_HAS_PROP(inst, memory_region),                                            \
+                (Z_GENERIC_SECTION(LINKER_DT_NODE_REGION_NAME(DT_INST_PHANDLE(inst, memory_region)))), \
+                (TERMINAL_DISPLAY_BUFFER_SECTION))
+
+#if defined(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP)
+#define TERMINAL_DISPLAY_BUFFERS_DEFINE(inst)                                                 \
+    BUILD_ASSERT(!DT_INST_NODE_HAS_PROP(inst, memory_region),                                 \
+                 "memory-region has no effect with CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP, use " \
+                 "CONFIG_TERMINAL_DISPLAY_BUFFER_CUSTOM_SECTION to place the heap instead");
+#define TERMINAL_DISPLAY_BUFFERS_INIT(inst)
+#define TERMINAL_DISPLAY_MAX_RESOLUTION_INIT(inst) \
+    .max_resolution = {                            \
+        .width = DT_INST_PROP(inst, width),        \
+        .height = DT_INST_PROP(inst, height),      \
+    },
+#else
+#define TERMINAL_DISPLAY_BUFFERS_DEFINE(inst)                                    \
+    static struct rgb24 buffer##inst[TERMINAL_DISPLAY_BUFFER_SIZE(inst)]         \
+        TERMINAL_DISPLAY_INST_BUFFER_SECTION(inst);                              \
+    static ATOMIC_DEFINE(dirty_pixels##inst, TERMINAL_DISPLAY_BUFFER_SIZE(inst)) \
+        TERMINAL_DISPLAY_INST_BUFFER_SECTION(inst);
+#define TERMINAL_DISPLAY_BUFFERS_INIT(inst) \
+    .buffer = buffer##inst,                 \
+    .dirty_pixels = dirty_pixels##inst,
+#define TERMINAL_DISPLAY_MAX_RESOLUTION_INIT(inst)
+#endif
+
 #define TERMINAL_DISPLAY_DEFINE(inst)                                                                            \
     LOG_INSTANCE_REGISTER(terminal_display, inst, CONFIG_TERMINAL_DISPLAY_LOG_LEVEL);                            \
-    K_KERNEL_THREAD_DEFINE(terminal_display_thread##inst, 2048, terminal_display_thread_entry,                   \
-                           DEVICE_DT_INST_GET(inst), NULL, NULL, CONFIG_TERMINAL_DISPLAY_THREAD_PRIORITY, 0, 0); \
-    static struct rgb24 buffer##inst[TERMINAL_DISPLAY_BUFFER_SIZE(inst)] = {0};                                  \
-    static ATOMIC_DEFINE(dirty_pixels##inst, TERMINAL_DISPLAY_BUFFER_SIZE(inst));                                \
+    TERMINAL_DISPLAY_THREAD_DEFINE(inst)                                                                         \
+    TERMINAL_DISPLAY_SPECIALIZE(inst)                                                                            \
+    TERMINAL_DISPLAY_SPECIALIZE_ENCODE(inst)                                                                     \
+    TERMINAL_DISPLAY_BUFFERS_DEFINE(inst)                                                                        \
+    PM_DEVICE_DT_INST_DEFINE(inst, terminal_display_pm_action);                                                  \
     static const struct terminal_display_config config##inst = {                                                 \
         .terminal = DEVICE_DT_GET(DT_INST_PROP(inst, terminal)),                                                 \
+        .origin = {                                                                                              \
+            .row = DT_INST_PROP(inst, origin_row),                                                               \
+            .column = DT_INST_PROP(inst, origin_column),                                                         \
+        },                                                                                                       \
+        TERMINAL_DISPLAY_MAX_RESOLUTION_INIT(inst)                                                               \
+        .auto_color_mode = TERMINAL_DISPLAY_AUTO_COLOR_MODE(inst),                                               \
+        .write = TERMINAL_DISPLAY_WRITE_FN(inst),                                                                \
+        .refresh = TERMINAL_DISPLAY_REFRESH_FN(inst),                                                            \
+        TERMINAL_DISPLAY_ENCODE_INIT(inst)                                                                       \
+        LOG_INSTANCE_PTR_INIT(log, terminal_display, inst)};                                                     \
+    static struct terminal_display_data data##inst = {                                                           \
+        TERMINAL_DISPLAY_RENDER_DATA_INIT(inst)                                                                  \
         .capabilities = {                                                                                        \
             .x_resolution = DT_INST_PROP(inst, width),                                                           \
             .y_resolution = DT_INST_PROP(inst, height),                                                          \
@@ -356,16 +1482,13 @@ static void terminal_display_thread_entry(void *d, void *p2, void *p3)
             .current_pixel_format = PIXEL_FORMAT_RGB_888,                                                        \
             .current_orientation = DISPLAY_ORIENTATION_NORMAL,                                                   \
         },                                                                                                       \
-        LOG_INSTANCE_PTR_INIT(log, terminal_display, inst)};                                                     \
-    static struct terminal_display_data data##inst = {                                                           \
-        .thread_sem = Z_SEM_INITIALIZER(data##inst.thread_sem, 0, 1),                                            \
-        .buffer = buffer##inst,                                                                                  \
-        .dirty_pixels = dirty_pixels##inst,                                                                      \
+        TERMINAL_DISPLAY_BUFFERS_INIT(inst)                                                                      \
+        .color_mode = TERMINAL_DISPLAY_DT_COLOR_MODE(inst),                                                      \
         .blanking = {                                                                                            \
             .on = true,                                                                                          \
             .previously_on = false,                                                                              \
         }};                                                                                                      \
-    DEVICE_DT_INST_DEFINE(inst, terminal_display_init, NULL, &data##inst, &config##inst,                         \
-                          POST_KERNEL, CONFIG_TERMINAL_DISPLAY_INIT_PRIORITY, &api);
+    DEVICE_DT_INST_DEFINE(inst, terminal_display_init, PM_DEVICE_DT_INST_GET(inst), &data##inst,                 \
+                          &config##inst, POST_KERNEL, CONFIG_TERMINAL_DISPLAY_INIT_PRIORITY, &api);
 
 DT_INST_FOREACH_STATUS_OKAY(TERMINAL_DISPLAY_DEFINE);
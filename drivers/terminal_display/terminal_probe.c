@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "terminal_probe.h"
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/__assert.h>
+#include <zephyr/sys/util.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* Every query is answered in order, and every terminal answers the
+ * primary device attributes query, so it goes last: once its reply
+ * arrives there is nothing more to wait for.
+ *
+ * - save the cursor, park it in the bottom right corner and ask where
+ *   it is (cursor position report), then restore it. This is the size.
+ * - XTGETTCAP "RGB" and "Co" (hex encoded) ask for direct color support
+ *   and the number of colors. Terminals that don't know XTGETTCAP
+ *   ignore these, and answering at all marks an xterm descendant.
+ * - primary device attributes. The first parameter tells the VT100
+ *   family apart from VT220 and later terminals. */
+static const char query[] = "\x1b"
+                            "7"
+                            "\x1b[999;999H"
+                            "\x1b[6n"
+                            "\x1b"
+                            "8"
+                            "\x1bP+q524742\x1b\\"
+                            "\x1bP+q436f\x1b\\"
+                            "\x1b[c";
+
+#define TERMINAL_PROBE_CAP_RGB "524742"
+#define TERMINAL_PROBE_CAP_COLORS "436f"
+
+struct terminal_probe_parser
+{
+    char sequence[64];
+    size_t length;
+    bool in_sequence;
+};
+
+static bool terminal_probe_starts_with(const char *sequence, const char *prefix)
+{
+    return strncmp(sequence, prefix, strlen(prefix)) == 0;
+}
+
+/* decodes a hex encoded decimal number, as XTGETTCAP replies with */
+static uint32_t terminal_probe_parse_hex_number(const char *hex)
+{
+    uint32_t value = 0;
+    while (isxdigit((unsigned char)hex[0]) && isxdigit((unsigned char)hex[1]))
+    {
+        char pair[3] = {hex[0], hex[1], '\0'};
+        const char digit = (char)strtoul(pair, NULL, 16);
+        if (digit < '0' || digit > '9')
+        {
+            break;
+        }
+        value = value * 10 + (digit - '0');
+        hex += 2;
+    }
+    return value;
+}
+
+/* handles one complete reply, returns true once the device attributes arrive */
+static bool terminal_probe_handle(const char *sequence, size_t length,
+                                  struct terminal_probe_result *result)
+{
+    const char final = sequence[length - 1];
+
+    if (sequence[1] == '[')
+    {
+        // "ESC [ ? level ; ... c" is the device attributes reply
+        if (final == 'c')
+        {
+            if (sequence[2] == '?')
+            {
+                result->conformance = (uint8_t)MIN(strtoul(&sequence[3], NULL, 10), UINT8_MAX);
+            }
+            result->answered = true;
+            return true;
+        }
+
+        // "ESC [ rows ; columns R" is the cursor position report
+        if (final == 'R')
+        {
+            char *end;
+            const unsigned long rows = strtoul(&sequence[2], &end, 10);
+            if (*end == ';')
+            {
+                result->rows = (uint16_t)MIN(rows, UINT16_MAX);
+                result->columns = (uint16_t)MIN(strtoul(end + 1, NULL, 10), UINT16_MAX);
+                result->answered = true;
+            }
+        }
+        return false;
+    }
+
+    // "ESC P 1 + r <cap> [= <value>] ESC \" is a known capability,
+    // "ESC P 0 + r ..." an unknown one
+    if (sequence[1] == 'P')
+    {
+        result->answered = true;
+        result->xterm = true;
+        const char *reply = &sequence[2];
+        if (!terminal_probe_starts_with(reply, "1+r"))
+        {
+            return false;
+        }
+        reply += 3;
+
+        if (terminal_probe_starts_with(reply, TERMINAL_PROBE_CAP_RGB))
+        {
+            result->truecolor = true;
+        }
+        else if (terminal_probe_starts_with(reply, TERMINAL_PROBE_CAP_COLORS "="))
+        {
+            result->colors = terminal_probe_parse_hex_number(reply + strlen(TERMINAL_PROBE_CAP_COLORS "="));
+        }
+    }
+
+    return false;
+}
+
+/* feeds one received byte, returns true once the device attributes arrive */
+static bool terminal_probe_feed(struct terminal_probe_parser *parser, char c,
+                                struct terminal_probe_result *result)
+{
+    // an escape either starts a reply, or is the start of a string terminator
+    if (c == '\x1b' && !(parser->in_sequence && parser->length > 1 && parser->sequence[1] == 'P'))
+    {
+        parser->in_sequence = true;
+        parser->length = 0;
+    }
+
+    if (!parser->in_sequence)
+    {
+        return false;
+    }
+
+    if (parser->length >= sizeof(parser->sequence) - 1)
+    {
+        // too long to be anything we asked for
+        parser->in_sequence = false;
+        return false;
+    }
+
+    parser->sequence[parser->length++] = c;
+    parser->sequence[parser->length] = '\0';
+
+    if (parser->length < 3)
+    {
+        return false;
+    }
+
+    const bool csi_done = parser->sequence[1] == '[' && c >= 0x40 && c <= 0x7e;
+    const bool dcs_done = parser->sequence[1] == 'P' && c == '\\' &&
+                          parser->sequence[parser->length - 2] == '\x1b';
+    if (!csi_done && !dcs_done)
+    {
+        return false;
+    }
+
+    parser->in_sequence = false;
+    return terminal_probe_handle(parser->sequence, parser->length, result);
+}
+
+int terminal_probe(const struct device *terminal, k_timeout_t timeout,
+                   struct terminal_probe_result *result)
+{
+    __ASSERT_NO_MSG(terminal != NULL);
+    __ASSERT_NO_MSG(result != NULL);
+
+    memset(result, 0, sizeof(*result));
+
+    // throw away anything that arrived before we asked
+    unsigned char c;
+    while (uart_poll_in(terminal, &c) == 0)
+    {
+    }
+
+    for (size_t i = 0; i < sizeof(query) - 1; i++)
+    {
+        uart_poll_out(terminal, query[i]);
+    }
+
+    struct terminal_probe_parser parser = {0};
+    const k_timepoint_t end = sys_timepoint_calc(timeout);
+    while (!sys_timepoint_expired(end))
+    {
+        const int ret = uart_poll_in(terminal, &c);
+        if (ret == -ENOSYS || ret == -ENOTSUP)
+        {
+            return ret;
+        }
+        if (ret != 0)
+        {
+            k_msleep(1);
+            continue;
+        }
+
+        if (terminal_probe_feed(&parser, (char)c, result))
+        {
+            return 0;
+        }
+    }
+
+    return result->answered ? 0 : -EAGAIN;
+}
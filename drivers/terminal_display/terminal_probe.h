@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __TERMINAL_DISPLAY_TERMINAL_PROBE_H__
+#define __TERMINAL_DISPLAY_TERMINAL_PROBE_H__
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+struct terminal_probe_result
+{
+    /* the terminal answered at least one query */
+    bool answered;
+    /* the terminal advertised 24-bit color */
+    bool truecolor;
+    /* number of colors advertised, 0 if unknown */
+    uint32_t colors;
+    /* the terminal answered XTGETTCAP, so it's an xterm descendant */
+    bool xterm;
+    /* first parameter of the device attributes reply: 1 or 6 for the
+     * VT100 family, 62 and up for VT220 and later. 0 if unknown */
+    uint8_t conformance;
+    /* size of the terminal in cells, 0 if unknown */
+    uint16_t rows;
+    uint16_t columns;
+};
+
+/* Queries the terminal on the other end of the uart for its size and color
+ * support, and parses the replies. The terminal's cursor is restored
+ * afterwards. Returns -EAGAIN if nothing answered within the timeout. */
+int terminal_probe(const struct device *terminal, k_timeout_t timeout,
+                   struct terminal_probe_result *result);
+
+#endif
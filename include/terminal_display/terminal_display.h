@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __TERMINAL_DISPLAY_TERMINAL_DISPLAY_H__
+#define __TERMINAL_DISPLAY_TERMINAL_DISPLAY_H__
+
+/* Terminal display specific extensions to the Zephyr display API */
+
+#include <zephyr/device.h>
+#include <stdint.h>
+
+/* how colors are encoded in the escape stream sent to the terminal */
+enum terminal_display_color_mode
+{
+    /* ESC[48;5;<index>m, the 256 color palette */
+    TERMINAL_DISPLAY_COLOR_MODE_256,
+    /* ESC[48;2;<r>;<g>;<b>m, 24-bit color */
+    TERMINAL_DISPLAY_COLOR_MODE_TRUECOLOR,
+    /* ESC[4<n>m and ESC[10<n>m, the 16 ANSI colors */
+    TERMINAL_DISPLAY_COLOR_MODE_16,
+    /* ESC[4<n>m, the 8 basic ANSI colors */
+    TERMINAL_DISPLAY_COLOR_MODE_8,
+};
+
+struct terminal_display_terminal_info
+{
+    /* the encoding currently in use */
+    enum terminal_display_color_mode color_mode;
+    /* size of the terminal in cells, 0 if it hasn't been probed */
+    uint16_t rows;
+    uint16_t columns;
+};
+
+struct terminal_display_stats
+{
+    /* refreshes completed */
+    uint32_t frames;
+    /* bytes written to the terminal */
+    uint32_t bytes;
+    /* refreshes that found the terminal suspended and had to resume it.
+     * only counted with CONFIG_TERMINAL_DISPLAY_PM */
+    uint32_t terminal_resumes;
+};
+
+/* copies the statistics of a terminal display instance into stats.
+ * requires CONFIG_TERMINAL_DISPLAY_STATS */
+int terminal_display_get_stats(const struct device *dev, struct terminal_display_stats *stats);
+
+/* Asks the terminal for its size and color support again, e.g. after a
+ * terminal has been (re)attached to the uart. Instances with color-mode
+ * "auto" switch to the best encoding the terminal supports and redraw.
+ * The probe runs from the render context, so this returns immediately. */
+int terminal_display_probe(const struct device *dev);
+
+/* copies what is known about the terminal of a terminal display instance */
+int terminal_display_get_terminal_info(const struct device *dev,
+                                       struct terminal_display_terminal_info *info);
+
+/* Changes the resolution of a terminal display instance, up to the width
+ * and height given in devicetree. The display is cleared to black. The
+ * buffers are reallocated, so this must not run concurrently with writes
+ * to the same display. Requires CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP,
+ * returns -ENOTSUP otherwise. */
+int terminal_display_set_resolution(const struct device *dev, uint16_t width, uint16_t height);
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* built into the native simulator runner, not the zephyr image */
+#include <stdint.h>
+#include <time.h>
+#include "host_clock.h"
+
+uint64_t host_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
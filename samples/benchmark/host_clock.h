@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __BENCHMARK_HOST_CLOCK_H__
+#define __BENCHMARK_HOST_CLOCK_H__
+
+#include <stdint.h>
+
+/* monotonic wall clock time of the host running native_sim */
+uint64_t host_clock_ns(void);
+
+#endif
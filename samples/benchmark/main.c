@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/pm/device_runtime.h>
+#include <terminal_display/terminal_display.h>
+#include <string.h>
+#include "host_clock.h"
+#include "test_uart.h"
+
+LOG_MODULE_REGISTER(test, CONFIG_TEST_LOG_LEVEL);
+
+#define DISPLAY_NODE DT_CHOSEN(zephyr_display)
+#define WIDTH DT_PROP(DISPLAY_NODE, width)
+#define HEIGHT DT_PROP(DISPLAY_NODE, height)
+#define TERMINAL_NODE DT_PROP(DISPLAY_NODE, terminal)
+#define FRAMES 32
+#define SPRITE 4
+#define IDLE_MS 500
+#define SPACED_FRAMES 4
+
+/* the pm variant draws to a test uart that counts its resumes */
+#if defined(CONFIG_TERMINAL_DISPLAY_PM) && DT_NODE_HAS_COMPAT(TERMINAL_NODE, xv_test_uart)
+#define TEST_PM 1
+BUILD_ASSERT(IDLE_MS > CONFIG_TERMINAL_DISPLAY_PM_AUTOSUSPEND_MS,
+             "The terminal has to suspend while idle");
+#endif
+
+static const struct device *const display = DEVICE_DT_GET(DISPLAY_NODE);
+static const struct device *const terminal = DEVICE_DT_GET(TERMINAL_NODE);
+
+static uint8_t frame[WIDTH * HEIGHT * 3];
+
+struct measurement
+{
+    uint64_t write_ns;
+    uint64_t refresh_ns;
+    uint32_t bytes;
+    uint32_t terminal_resumes;
+};
+
+#if DT_NODE_HAS_COMPAT(TERMINAL_NODE, zephyr_uart_emul)
+/* nobody is listening on the emulated uart, so throw away whatever it sends */
+static void discard_tx(const struct device *dev, size_t size, void *user_data)
+{
+    ARG_UNUSED(size);
+    ARG_UNUSED(user_data);
+    uart_emul_flush_tx_data(dev);
+}
+#endif
+
+static struct terminal_display_stats get_stats(void)
+{
+    struct terminal_display_stats stats;
+    zassert_ok(terminal_display_get_stats(display, &stats));
+    return stats;
+}
+
+static void wait_for_frames(uint32_t frames)
+{
+    // sleeping lets the render context run, and costs
+    // no host time since native_sim isn't real time
+    while (get_stats().frames < frames)
+    {
+        k_msleep(1);
+    }
+}
+
+/* writes the buffer as an incomplete frame, then completes it with an empty
+ * write, so the write and refresh are timed separately no matter how the
+ * render context is scheduled relative to this thread */
+static void measure(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *buf,
+                    struct measurement *measurement)
+{
+    struct display_buffer_descriptor desc = {
+        .buf_size = width * height * 3,
+        .width = width,
+        .height = height,
+        .pitch = width,
+        .frame_incomplete = true,
+    };
+    const struct display_buffer_descriptor complete = {
+        .frame_incomplete = false,
+    };
+
+    const struct terminal_display_stats before = get_stats();
+
+    const uint64_t start = host_clock_ns();
+    zassert_ok(display_write(display, x, y, &desc, buf));
+    const uint64_t written = host_clock_ns();
+    zassert_ok(display_write(display, 0, 0, &complete, buf));
+    wait_for_frames(before.frames + 1);
+    const uint64_t refreshed = host_clock_ns();
+
+    measurement->write_ns += written - start;
+    measurement->refresh_ns += refreshed - written;
+    const struct terminal_display_stats after = get_stats();
+    measurement->bytes += after.bytes - before.bytes;
+    measurement->terminal_resumes += after.terminal_resumes - before.terminal_resumes;
+}
+
+static void report(const char *name, const struct measurement *measurement)
+{
+    TC_PRINT("%s: write %llu ns/frame, refresh %llu ns/frame, %u bytes/frame, %u terminal resumes\n",
+             name, (unsigned long long)(measurement->write_ns / FRAMES),
+             (unsigned long long)(measurement->refresh_ns / FRAMES), measurement->bytes / FRAMES,
+             measurement->terminal_resumes);
+}
+
+/* a gradient that shifts every frame, so every pixel is dirty */
+static void draw_gradient(uint16_t width, uint16_t height, int i)
+{
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            uint8_t *pixel = &frame[(y * width + x) * 3];
+            pixel[0] = (x * 4 + i * 8) & 0xff;
+            pixel[1] = (y * 4 + i * 8) & 0xff;
+            pixel[2] = ((x + y) * 2 + i * 8) & 0xff;
+        }
+    }
+}
+
+ZTEST(terminal_display_benchmark, test_full_frame)
+{
+    struct measurement measurement = {0};
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        draw_gradient(WIDTH, HEIGHT, i);
+        measure(0, 0, WIDTH, HEIGHT, frame, &measurement);
+    }
+
+    report("full frame", &measurement);
+}
+
+ZTEST(terminal_display_benchmark, test_static)
+{
+    struct measurement measurement = {0};
+
+    // the same frame over and over again, so nothing should be redrawn.
+    // Dithering depends only on the position, so holds for it as well.
+    draw_gradient(WIDTH, HEIGHT, 0);
+    measure(0, 0, WIDTH, HEIGHT, frame, &(struct measurement){0});
+    for (int i = 0; i < FRAMES; i++)
+    {
+        measure(0, 0, WIDTH, HEIGHT, frame, &measurement);
+    }
+
+    report("static", &measurement);
+    zassert_true(measurement.bytes / FRAMES < WIDTH, "Unchanged pixels were redrawn");
+}
+
+ZTEST(terminal_display_benchmark, test_resolution)
+{
+    if (!IS_ENABLED(CONFIG_TERMINAL_DISPLAY_BUFFER_HEAP))
+    {
+        zassert_equal(terminal_display_set_resolution(display, WIDTH / 2, HEIGHT / 2), -ENOTSUP);
+        ztest_test_skip();
+    }
+
+    // devicetree gives the largest resolution
+    zassert_equal(terminal_display_set_resolution(display, WIDTH + 1, HEIGHT), -EINVAL);
+
+    const uint32_t frames = get_stats().frames;
+    zassert_ok(terminal_display_set_resolution(display, WIDTH / 2, HEIGHT / 2));
+    wait_for_frames(frames + 1);
+
+    struct display_capabilities capabilities;
+    display_get_capabilities(display, &capabilities);
+    zassert_equal(capabilities.x_resolution, WIDTH / 2);
+    zassert_equal(capabilities.y_resolution, HEIGHT / 2);
+
+    struct measurement measurement = {0};
+    for (int i = 0; i < FRAMES; i++)
+    {
+        draw_gradient(WIDTH / 2, HEIGHT / 2, i);
+        measure(0, 0, WIDTH / 2, HEIGHT / 2, frame, &measurement);
+    }
+    report("half resolution", &measurement);
+
+    const uint32_t restored = get_stats().frames;
+    zassert_ok(terminal_display_set_resolution(display, WIDTH, HEIGHT));
+    wait_for_frames(restored + 1);
+}
+
+ZTEST(terminal_display_benchmark, test_sprite)
+{
+    struct measurement measurement = {0};
+    uint8_t sprite[SPRITE * SPRITE * 3];
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        memset(sprite, (i & 1) ? 0xff : 0x00, sizeof(sprite));
+        const uint16_t x = (i * 7) % (WIDTH - SPRITE);
+        const uint16_t y = (i * 5) % (HEIGHT - SPRITE);
+        measure(x, y, SPRITE, SPRITE, sprite, &measurement);
+    }
+
+    report("sprite", &measurement);
+}
+
+ZTEST(terminal_display_benchmark, test_idle)
+{
+    // with nothing written, the render context shouldn't wake at all
+    const struct terminal_display_stats idle = get_stats();
+#if defined(TEST_PM)
+    struct test_uart_stats uart_idle;
+    test_uart_get_stats(terminal, &uart_idle);
+#endif
+    k_msleep(IDLE_MS);
+    zassert_equal(get_stats().frames, idle.frames, "Refreshed while idle");
+
+    // nor while blanked, no matter what is written
+    zassert_ok(display_blanking_on(display));
+    wait_for_frames(idle.frames + 1);
+    const struct terminal_display_stats blanked = get_stats();
+
+    struct display_buffer_descriptor desc = {
+        .buf_size = sizeof(frame),
+        .width = WIDTH,
+        .height = HEIGHT,
+        .pitch = WIDTH,
+    };
+    for (int i = 0; i < FRAMES; i++)
+    {
+        memset(frame, i, sizeof(frame));
+        zassert_ok(display_write(display, 0, 0, &desc, frame));
+    }
+    k_msleep(IDLE_MS);
+    zassert_equal(get_stats().frames, blanked.frames, "Refreshed while blanked");
+#if defined(TEST_PM)
+    enum pm_device_state state;
+    zassert_ok(pm_device_state_get(terminal, &state));
+    zassert_equal(state, PM_DEVICE_STATE_SUSPENDED, "Terminal didn't suspend while blanked");
+#endif
+
+    zassert_ok(display_blanking_off(display));
+    wait_for_frames(blanked.frames + 1);
+
+    const struct terminal_display_stats after = get_stats();
+    TC_PRINT("idle: %u frames, %u terminal resumes over %d ms idle and %d ms blanked\n",
+             after.frames - idle.frames, after.terminal_resumes - idle.terminal_resumes, IDLE_MS,
+             IDLE_MS);
+    // the terminal is only ever resumed to draw a frame
+    zassert_true(after.terminal_resumes - idle.terminal_resumes <= after.frames - idle.frames,
+                 "Terminal resumed without drawing");
+#if defined(TEST_PM)
+    struct test_uart_stats uart_after;
+    test_uart_get_stats(terminal, &uart_after);
+    zassert_equal(uart_after.resumes - uart_idle.resumes,
+                  after.terminal_resumes - idle.terminal_resumes);
+#endif
+}
+
+ZTEST(terminal_display_benchmark, test_suspend)
+{
+#if defined(TEST_PM)
+    struct test_uart_stats before;
+    test_uart_get_stats(terminal, &before);
+
+    // frames further apart than the autosuspend delay find the terminal
+    // suspended, so each of them has to resume it
+    struct measurement measurement = {0};
+    for (int i = 0; i < SPACED_FRAMES; i++)
+    {
+        k_msleep(CONFIG_TERMINAL_DISPLAY_PM_AUTOSUSPEND_MS * 2);
+
+        enum pm_device_state state;
+        zassert_ok(pm_device_state_get(terminal, &state));
+        zassert_equal(state, PM_DEVICE_STATE_SUSPENDED, "Terminal didn't suspend after a frame");
+
+        draw_gradient(WIDTH, HEIGHT, i);
+        measure(0, 0, WIDTH, HEIGHT, frame, &measurement);
+    }
+
+    TC_PRINT("suspend: %u terminal resumes over %d frames %d ms apart\n",
+             measurement.terminal_resumes, SPACED_FRAMES,
+             CONFIG_TERMINAL_DISPLAY_PM_AUTOSUSPEND_MS * 2);
+
+    struct test_uart_stats after;
+    test_uart_get_stats(terminal, &after);
+    zassert_equal(measurement.terminal_resumes, SPACED_FRAMES);
+    zassert_equal(after.resumes - before.resumes, SPACED_FRAMES);
+    zassert_equal(after.suspended_writes, 0, "Wrote to a suspended terminal");
+#else
+    ztest_test_skip();
+#endif
+}
+
+static void *benchmark_setup(void)
+{
+    zassert_true(device_is_ready(display), "Device is not ready");
+#if DT_NODE_HAS_COMPAT(TERMINAL_NODE, zephyr_uart_emul)
+    uart_emul_callback_tx_data_ready_set(terminal, discard_tx, NULL);
+#endif
+#if defined(TEST_PM)
+    // suspends the terminal until the driver draws to it
+    zassert_ok(pm_device_runtime_enable(terminal));
+#endif
+
+    // paint the blank screen before timing anything
+    const uint32_t frames = get_stats().frames;
+    zassert_ok(display_blanking_off(display));
+    wait_for_frames(frames + 1);
+
+    return NULL;
+}
+
+ZTEST_SUITE(terminal_display_benchmark, NULL, benchmark_setup, NULL, NULL, NULL);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT xv_test_uart
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/sys/__assert.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include "test_uart.h"
+
+struct test_uart_data
+{
+    atomic_t suspended;
+    atomic_t resumes;
+    atomic_t suspended_writes;
+};
+
+static int test_uart_poll_in(const struct device *dev, unsigned char *c)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(c);
+    // nothing ever answers
+    return -1;
+}
+
+static void test_uart_poll_out(const struct device *dev, unsigned char c)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    ARG_UNUSED(c);
+
+    struct test_uart_data *data = dev->data;
+    if (atomic_get(&data->suspended))
+    {
+        atomic_inc(&data->suspended_writes);
+    }
+}
+
+#if defined(CONFIG_PM_DEVICE)
+static int test_uart_pm_action(const struct device *dev, enum pm_device_action action)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    struct test_uart_data *data = dev->data;
+
+    switch (action)
+    {
+    case PM_DEVICE_ACTION_SUSPEND:
+        atomic_set(&data->suspended, 1);
+        return 0;
+    case PM_DEVICE_ACTION_RESUME:
+        atomic_set(&data->suspended, 0);
+        atomic_inc(&data->resumes);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+#endif
+
+void test_uart_get_stats(const struct device *dev, struct test_uart_stats *stats)
+{
+    __ASSERT_NO_MSG(dev != NULL);
+    __ASSERT_NO_MSG(stats != NULL);
+
+    struct test_uart_data *data = dev->data;
+    stats->resumes = atomic_get(&data->resumes);
+    stats->suspended_writes = atomic_get(&data->suspended_writes);
+}
+
+static int test_uart_init(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+    return 0;
+}
+
+static DEVICE_API(uart, test_uart_api) = {
+    .poll_in = test_uart_poll_in,
+    .poll_out = test_uart_poll_out,
+};
+
+#define TEST_UART_DEFINE(inst)                                                                   \
+    static struct test_uart_data test_uart_data_##inst;                                          \
+    PM_DEVICE_DT_INST_DEFINE(inst, test_uart_pm_action);                                         \
+    DEVICE_DT_INST_DEFINE(inst, test_uart_init, PM_DEVICE_DT_INST_GET(inst),                     \
+                          &test_uart_data_##inst, NULL, PRE_KERNEL_1,                            \
+                          CONFIG_SERIAL_INIT_PRIORITY, &test_uart_api);
+
+DT_INST_FOREACH_STATUS_OKAY(TEST_UART_DEFINE)
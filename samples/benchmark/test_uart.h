@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __BENCHMARK_TEST_UART_H__
+#define __BENCHMARK_TEST_UART_H__
+
+#include <zephyr/device.h>
+#include <stdint.h>
+
+struct test_uart_stats
+{
+    /* times the uart was resumed */
+    uint32_t resumes;
+    /* bytes written while the uart was suspended, which should never happen */
+    uint32_t suspended_writes;
+};
+
+/* copies the statistics of an xv,test-uart device */
+void test_uart_get_stats(const struct device *dev, struct test_uart_stats *stats);
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/devicetree.h>
+#include <terminal_display/terminal_display.h>
+#include <string.h>
+#include "screen.h"
+
+LOG_MODULE_REGISTER(test, CONFIG_TEST_LOG_LEVEL);
+
+#define DISPLAY_NODE DT_CHOSEN(zephyr_display)
+#define SECOND_NODE DT_NODELABEL(second_display)
+#define WIDTH DT_PROP(DISPLAY_NODE, width)
+#define HEIGHT DT_PROP(DISPLAY_NODE, height)
+#define FRAMES 16
+#define SPRITE 6
+
+/* cells the driver never wrote to */
+#define UNTOUCHED UINT32_MAX
+
+BUILD_ASSERT(DT_ENUM_IDX(DISPLAY_NODE, color_mode) == 1, "The screen is compared in truecolor");
+
+/* the viewports variant adds a second display on the same terminal, to
+ * the right of the first with a gap between them */
+#if DT_NODE_HAS_STATUS(SECOND_NODE, okay)
+#define VIEWPORTS 2
+BUILD_ASSERT(DT_ENUM_IDX(SECOND_NODE, color_mode) == 1, "The screen is compared in truecolor");
+BUILD_ASSERT(DT_PROP(SECOND_NODE, width) == WIDTH && DT_PROP(SECOND_NODE, height) == HEIGHT,
+             "The displays are the same size");
+BUILD_ASSERT(DT_SAME_NODE(DT_PROP(SECOND_NODE, terminal), DT_PROP(DISPLAY_NODE, terminal)),
+             "The displays share a terminal");
+BUILD_ASSERT(DT_PROP(SECOND_NODE, origin_column) >= DT_PROP(DISPLAY_NODE, origin_column) + WIDTH * 2,
+             "The second display is right of the first");
+#define ROWS (MAX(DT_PROP(DISPLAY_NODE, origin_row), DT_PROP(SECOND_NODE, origin_row)) + HEIGHT)
+#define COLUMNS (DT_PROP(SECOND_NODE, origin_column) + WIDTH * 2)
+#else
+#define VIEWPORTS 1
+#define ROWS (DT_PROP(DISPLAY_NODE, origin_row) + HEIGHT)
+#define COLUMNS (DT_PROP(DISPLAY_NODE, origin_column) + WIDTH * 2)
+#endif
+
+struct viewport
+{
+    const struct device *display;
+    uint16_t row;
+    uint16_t column;
+    bool blanked;
+    /* what the display should show, updated along with every write */
+    uint8_t image[HEIGHT][WIDTH][3];
+};
+
+#define VIEWPORT_INIT(node)                     \
+    {                                           \
+        .display = DEVICE_DT_GET(node),         \
+        .row = DT_PROP(node, origin_row),       \
+        .column = DT_PROP(node, origin_column), \
+    }
+
+static struct viewport viewports[VIEWPORTS] = {
+    VIEWPORT_INIT(DISPLAY_NODE),
+#if VIEWPORTS > 1
+    VIEWPORT_INIT(SECOND_NODE),
+#endif
+};
+static const struct device *const terminal = DEVICE_DT_GET(DT_PROP(DISPLAY_NODE, terminal));
+static uint8_t frame[WIDTH * HEIGHT * 3];
+
+/* the terminal is exactly as wide as the rightmost display, so the last
+ * column of its rows leaves the terminal with a pending wrap */
+static uint32_t cells[ROWS * COLUMNS];
+static struct screen screen;
+static uint64_t last_tx_cycles;
+
+/* runs on the render context, for every byte the driver writes */
+static void capture_tx(const struct device *dev, size_t size, void *user_data)
+{
+    ARG_UNUSED(size);
+    ARG_UNUSED(user_data);
+
+    uint8_t data[64];
+    size_t length;
+    while ((length = uart_emul_get_tx_data(dev, data, sizeof(data))) > 0)
+    {
+        screen_feed(&screen, data, length);
+    }
+    last_tx_cycles = k_cycle_get_64();
+}
+
+static uint32_t get_frames(const struct device *display)
+{
+    struct terminal_display_stats stats;
+    zassert_ok(terminal_display_get_stats(display, &stats));
+    return stats.frames;
+}
+
+static void wait_for_frames(const struct device *display, uint32_t frames)
+{
+    while (get_frames(display) < frames)
+    {
+        k_msleep(1);
+    }
+}
+
+/* writes the buffer as an incomplete frame, then completes it with an
+ * empty write. Returns the time from completing the frame until the last
+ * byte of the refresh reached the uart. */
+static uint64_t draw(struct viewport *viewport, uint16_t x, uint16_t y, uint16_t width,
+                     uint16_t height, const uint8_t *buf)
+{
+    struct display_buffer_descriptor desc = {
+        .buf_size = width * height * 3,
+        .width = width,
+        .height = height,
+        .pitch = width,
+        .frame_incomplete = true,
+    };
+    const struct display_buffer_descriptor complete = {
+        .frame_incomplete = false,
+    };
+
+    for (uint16_t sy = 0; sy < height; sy++)
+    {
+        memcpy(viewport->image[y + sy][x], &buf[sy * width * 3], width * 3);
+    }
+
+    const uint32_t frames = get_frames(viewport->display);
+    zassert_ok(display_write(viewport->display, x, y, &desc, buf));
+    const uint64_t start = k_cycle_get_64();
+    zassert_ok(display_write(viewport->display, 0, 0, &complete, buf));
+    wait_for_frames(viewport->display, frames + 1);
+
+    return last_tx_cycles > start ? last_tx_cycles - start : 0;
+}
+
+/* every pixel is two cells wide, and cells outside of the viewports
+ * are never written to */
+static void check_screen(void)
+{
+    zassert_equal(screen.errors, 0, "Terminal got %u bad sequences", screen.errors);
+
+    for (uint16_t row = 0; row < ROWS; row++)
+    {
+        for (uint16_t column = 0; column < COLUMNS; column++)
+        {
+            uint32_t expected = UNTOUCHED;
+            for (int i = 0; i < VIEWPORTS; i++)
+            {
+                const struct viewport *viewport = &viewports[i];
+                if (row < viewport->row || row >= viewport->row + HEIGHT ||
+                    column < viewport->column || column >= viewport->column + WIDTH * 2)
+                {
+                    continue;
+                }
+
+                const uint8_t *pixel =
+                    viewport->image[row - viewport->row][(column - viewport->column) / 2];
+                expected = viewport->blanked ? SCREEN_TRUECOLOR(0, 0, 0)
+                                             : SCREEN_TRUECOLOR(pixel[0], pixel[1], pixel[2]);
+            }
+            const uint32_t actual = screen_cell(&screen, row, column);
+            zassert_equal(actual, expected, "Cell %u,%u is %08x instead of %08x", row, column,
+                          actual, expected);
+        }
+    }
+}
+
+static void report(const char *name, uint64_t cycles, int frames)
+{
+    TC_PRINT("%s: refresh %llu ns/frame (%s)\n", name,
+             (unsigned long long)(k_cyc_to_ns_floor64(cycles) / frames),
+             IS_ENABLED(CONFIG_TERMINAL_DISPLAY_PARALLEL) ? "parallel" : "serial");
+}
+
+/* a gradient that shifts every frame, so every pixel is dirty */
+static void draw_gradient(uint8_t *buf, int i)
+{
+    for (int y = 0; y < HEIGHT; y++)
+    {
+        for (int x = 0; x < WIDTH; x++)
+        {
+            uint8_t *pixel = &buf[(y * WIDTH + x) * 3];
+            pixel[0] = (x * 4 + i * 8) & 0xff;
+            pixel[1] = (y * 4 + i * 8) & 0xff;
+            pixel[2] = ((x + y) * 2 + i * 8) & 0xff;
+        }
+    }
+}
+
+/* horizontal stripes of one color, so refreshes are mostly long runs */
+static void draw_stripes(uint8_t *buf, int i)
+{
+    for (int y = 0; y < HEIGHT; y++)
+    {
+        const uint8_t shade = ((y / 8 + i) * 37) & 0xff;
+        for (int x = 0; x < WIDTH; x++)
+        {
+            memset(&buf[(y * WIDTH + x) * 3], shade, 3);
+        }
+    }
+}
+
+ZTEST(terminal_display_parallel, test_full_frame)
+{
+    uint64_t cycles = 0;
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        draw_gradient(frame, i);
+        cycles += draw(&viewports[0], 0, 0, WIDTH, HEIGHT, frame);
+        check_screen();
+    }
+
+    report("full frame", cycles, FRAMES);
+}
+
+ZTEST(terminal_display_parallel, test_flat)
+{
+    uint64_t cycles = 0;
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        draw_stripes(frame, i);
+        cycles += draw(&viewports[0], 0, 0, WIDTH, HEIGHT, frame);
+        check_screen();
+    }
+
+    report("flat", cycles, FRAMES);
+}
+
+ZTEST(terminal_display_parallel, test_sprite)
+{
+    uint8_t sprite[SPRITE * SPRITE * 3];
+    uint64_t cycles = 0;
+
+    // a few dirty pixels on either side of where the bands are split
+    for (int i = 0; i < FRAMES; i++)
+    {
+        memset(sprite, (i * 53) & 0xff, sizeof(sprite));
+        const uint16_t x = (i * 7) % (WIDTH - SPRITE);
+        const uint16_t y = HEIGHT / 2 - SPRITE + (i % (SPRITE * 2));
+        cycles += draw(&viewports[0], x, y, SPRITE, SPRITE, sprite);
+        check_screen();
+    }
+
+    report("sprite", cycles, FRAMES);
+}
+
+ZTEST(terminal_display_parallel, test_blanking)
+{
+    struct viewport *viewport = &viewports[0];
+    draw_gradient(frame, 0);
+    draw(viewport, 0, 0, WIDTH, HEIGHT, frame);
+
+    uint32_t frames = get_frames(viewport->display);
+    zassert_ok(display_blanking_on(viewport->display));
+    viewport->blanked = true;
+    wait_for_frames(viewport->display, frames + 1);
+    check_screen();
+
+    // coming back redraws everything
+    frames = get_frames(viewport->display);
+    zassert_ok(display_blanking_off(viewport->display));
+    viewport->blanked = false;
+    wait_for_frames(viewport->display, frames + 1);
+    check_screen();
+}
+
+#if VIEWPORTS > 1
+static K_THREAD_STACK_DEFINE(second_stack, 2048);
+static struct k_thread second_thread;
+static uint8_t second_frame[WIDTH * HEIGHT * 3];
+
+static void draw_second(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        draw_gradient(second_frame, i);
+        draw(&viewports[1], 0, 0, WIDTH, HEIGHT, second_frame);
+    }
+}
+#endif
+
+ZTEST(terminal_display_parallel, test_viewports)
+{
+#if VIEWPORTS > 1
+    // both displays refresh at the same time, taking turns on the terminal
+    k_thread_create(&second_thread, second_stack, K_THREAD_STACK_SIZEOF(second_stack), draw_second,
+                    NULL, NULL, NULL, k_thread_priority_get(k_current_get()), 0, K_NO_WAIT);
+    for (int i = 0; i < FRAMES; i++)
+    {
+        draw_stripes(frame, i);
+        draw(&viewports[0], 0, 0, WIDTH, HEIGHT, frame);
+    }
+    zassert_ok(k_thread_join(&second_thread, K_FOREVER));
+
+    check_screen();
+#else
+    ztest_test_skip();
+#endif
+}
+
+static void *parallel_setup(void)
+{
+    for (int i = 0; i < VIEWPORTS; i++)
+    {
+        zassert_true(device_is_ready(viewports[i].display), "Device is not ready");
+        wait_for_frames(viewports[i].display, 1);
+    }
+
+    // start reading from a known point: after the frames drawn at boot,
+    // whatever of them still sits in the uart's buffer is thrown away
+    uart_emul_flush_tx_data(terminal);
+    screen_init(&screen, cells, ROWS, COLUMNS);
+    for (size_t i = 0; i < ARRAY_SIZE(cells); i++)
+    {
+        cells[i] = UNTOUCHED;
+    }
+    uart_emul_callback_tx_data_ready_set(terminal, capture_tx, NULL);
+
+    // turning blanking off redraws every pixel
+    for (int i = 0; i < VIEWPORTS; i++)
+    {
+        const uint32_t frames = get_frames(viewports[i].display);
+        zassert_ok(display_blanking_off(viewports[i].display));
+        wait_for_frames(viewports[i].display, frames + 1);
+    }
+    check_screen();
+
+    return NULL;
+}
+
+ZTEST_SUITE(terminal_display_parallel, NULL, parallel_setup, NULL, NULL, NULL);
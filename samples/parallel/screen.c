@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "screen.h"
+#include <zephyr/sys/__assert.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCREEN_MAX_PARAMETERS 8
+
+void screen_init(struct screen *screen, uint32_t *cells, uint16_t rows, uint16_t columns)
+{
+    __ASSERT_NO_MSG(screen != NULL);
+    __ASSERT_NO_MSG(cells != NULL);
+
+    memset(screen, 0, sizeof(*screen));
+    screen->cells = cells;
+    screen->rows = rows;
+    screen->columns = columns;
+    memset(cells, 0, (size_t)rows * columns * sizeof(*cells));
+}
+
+static void screen_line_feed(struct screen *screen)
+{
+    if (screen->row + 1 >= screen->rows)
+    {
+        // the driver never draws past its own bottom row
+        screen->errors++;
+        return;
+    }
+    screen->row++;
+}
+
+static void screen_print(struct screen *screen, char c)
+{
+    if (screen->wrap_pending)
+    {
+        screen->column = 0;
+        screen->wrap_pending = false;
+        screen_line_feed(screen);
+    }
+
+    screen->cells[(size_t)screen->row * screen->columns + screen->column] = screen->background;
+    screen->last = c;
+
+    // like a real terminal, the cursor stays in the last column
+    // until the next character arrives
+    if (screen->column + 1 == screen->columns)
+    {
+        screen->wrap_pending = true;
+    }
+    else
+    {
+        screen->column++;
+    }
+}
+
+static void screen_move(struct screen *screen, int32_t row, int32_t column)
+{
+    screen->row = CLAMP(row, 0, screen->rows - 1);
+    screen->column = CLAMP(column, 0, screen->columns - 1);
+    screen->wrap_pending = false;
+}
+
+static void screen_sgr(struct screen *screen, const uint32_t *parameters, size_t count)
+{
+    if (count == 0)
+    {
+        screen->background = 0;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint32_t p = parameters[i];
+        if (p == 0)
+        {
+            screen->background = 0;
+        }
+        else if (p >= 40 && p <= 47)
+        {
+            screen->background = SCREEN_16(p - 40);
+        }
+        else if (p >= 100 && p <= 107)
+        {
+            screen->background = SCREEN_16(p - 100 + 8);
+        }
+        else if (p == 48 && i + 2 < count && parameters[i + 1] == 5)
+        {
+            screen->background = SCREEN_256(parameters[i + 2] & 0xff);
+            i += 2;
+        }
+        else if (p == 48 && i + 4 < count && parameters[i + 1] == 2)
+        {
+            screen->background = SCREEN_TRUECOLOR(parameters[i + 2] & 0xff, parameters[i + 3] & 0xff,
+                                                  parameters[i + 4] & 0xff);
+            i += 4;
+        }
+        else
+        {
+            screen->errors++;
+            return;
+        }
+    }
+}
+
+static void screen_csi(struct screen *screen, char final)
+{
+    uint32_t parameters[SCREEN_MAX_PARAMETERS] = {0};
+    size_t count = 0;
+
+    // parameters are separated by ';', and an empty one is 0
+    if (screen->length > 0)
+    {
+        const char *p = screen->sequence;
+        count = 1;
+        while (*p != '\0')
+        {
+            if (*p == ';')
+            {
+                if (count == ARRAY_SIZE(parameters))
+                {
+                    screen->errors++;
+                    return;
+                }
+                count++;
+            }
+            else if (*p >= '0' && *p <= '9')
+            {
+                parameters[count - 1] = parameters[count - 1] * 10 + (*p - '0');
+            }
+            else
+            {
+                screen->errors++;
+                return;
+            }
+            p++;
+        }
+    }
+
+    // cursor motion and repeat counts default to 1
+    const int32_t n = MAX(parameters[0], 1);
+
+    switch (final)
+    {
+    case 'H':
+        screen_move(screen, n - 1, (int32_t)MAX(parameters[1], 1) - 1);
+        break;
+    case 'A':
+        screen_move(screen, screen->row - n, screen->column);
+        break;
+    case 'B':
+        screen_move(screen, screen->row + n, screen->column);
+        break;
+    case 'C':
+        screen_move(screen, screen->row, screen->column + n);
+        break;
+    case 'D':
+        screen_move(screen, screen->row, screen->column - n);
+        break;
+    case 'm':
+        screen_sgr(screen, parameters, count);
+        break;
+    case 'b':
+        // REP repeats the last printed character
+        for (int32_t i = 0; i < n; i++)
+        {
+            screen_print(screen, screen->last);
+        }
+        break;
+    case 'X':
+        // ECH erases in the current background, and doesn't move the cursor
+        for (int32_t i = 0; i < n && screen->column + i < screen->columns; i++)
+        {
+            screen->cells[(size_t)screen->row * screen->columns + screen->column + i] =
+                screen->background;
+        }
+        break;
+    default:
+        screen->errors++;
+        break;
+    }
+}
+
+void screen_feed(struct screen *screen, const uint8_t *data, size_t length)
+{
+    __ASSERT_NO_MSG(screen != NULL);
+    __ASSERT_NO_MSG(data != NULL);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        const char c = (char)data[i];
+
+        switch (screen->parser)
+        {
+        case SCREEN_GROUND:
+            if (c == '\x1b')
+            {
+                screen->parser = SCREEN_ESCAPE;
+            }
+            else if (c == '\r')
+            {
+                screen_move(screen, screen->row, 0);
+            }
+            else if (c == '\n')
+            {
+                screen->wrap_pending = false;
+                screen_line_feed(screen);
+            }
+            else if (c >= 0x20 && c <= 0x7e)
+            {
+                screen_print(screen, c);
+            }
+            else
+            {
+                screen->errors++;
+            }
+            break;
+        case SCREEN_ESCAPE:
+            if (c == '[')
+            {
+                screen->parser = SCREEN_CSI;
+                screen->length = 0;
+                screen->sequence[0] = '\0';
+            }
+            else
+            {
+                screen->errors++;
+                screen->parser = SCREEN_GROUND;
+            }
+            break;
+        case SCREEN_CSI:
+            if (c >= 0x40 && c <= 0x7e)
+            {
+                screen_csi(screen, c);
+                screen->parser = SCREEN_GROUND;
+            }
+            else if (screen->length + 1 < sizeof(screen->sequence))
+            {
+                screen->sequence[screen->length++] = c;
+                screen->sequence[screen->length] = '\0';
+            }
+            else
+            {
+                screen->errors++;
+                screen->parser = SCREEN_GROUND;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __PARALLEL_SCREEN_H__
+#define __PARALLEL_SCREEN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* what a cell of the screen holds: its background color, tagged with the
+ * SGR that set it. 0 is the terminal's default background. */
+#define SCREEN_TRUECOLOR(r, g, b) ((1u << 24) | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (b))
+#define SCREEN_256(index) ((2u << 24) | (index))
+#define SCREEN_16(index) ((3u << 24) | (index))
+
+/* A minimal VT100 style terminal: it follows the escape sequences the
+ * driver sends, and records the background color of every cell. Anything
+ * it doesn't understand, and any scrolling, is counted as an error. */
+struct screen
+{
+    uint32_t *cells;
+    uint16_t rows;
+    uint16_t columns;
+    uint16_t row;
+    uint16_t column;
+    /* the last column was written, and the next character wraps */
+    bool wrap_pending;
+    uint32_t background;
+    char last;
+    uint32_t errors;
+    enum
+    {
+        SCREEN_GROUND,
+        SCREEN_ESCAPE,
+        SCREEN_CSI,
+    } parser;
+    char sequence[32];
+    size_t length;
+};
+
+/* cells holds rows * columns entries, row after row */
+void screen_init(struct screen *screen, uint32_t *cells, uint16_t rows, uint16_t columns);
+
+/* interprets bytes sent to the terminal */
+void screen_feed(struct screen *screen, const uint8_t *data, size_t length);
+
+static inline uint32_t screen_cell(const struct screen *screen, uint16_t row, uint16_t column)
+{
+    return screen->cells[(size_t)row * screen->columns + column];
+}
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2025 Noah Luskey <noah@xv.engineering>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/devicetree.h>
+#include <terminal_display/terminal_display.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(test, CONFIG_TEST_LOG_LEVEL);
+
+#define DISPLAY_NODE DT_CHOSEN(zephyr_display)
+#define WIDTH DT_PROP(DISPLAY_NODE, width)
+#define HEIGHT DT_PROP(DISPLAY_NODE, height)
+
+BUILD_ASSERT(DT_ENUM_HAS_VALUE(DISPLAY_NODE, color_mode, auto), "The display follows the probe");
+BUILD_ASSERT(!IS_ENABLED(CONFIG_TERMINAL_DISPLAY_FILL_REP) && !IS_ENABLED(CONFIG_TERMINAL_DISPLAY_FILL_ECH),
+             "REP and ECH are only used if the probe allows them");
+
+static const struct device *const display = DEVICE_DT_GET(DISPLAY_NODE);
+static const struct device *const terminal = DEVICE_DT_GET(DT_PROP(DISPLAY_NODE, terminal));
+
+static uint8_t frame[WIDTH * HEIGHT * 3];
+
+/* what the terminal answers once the probe's last query arrives, NULL
+ * for a terminal that doesn't answer at all */
+static const char *volatile reply;
+
+/* what the driver sent since the last reset_output() */
+static struct
+{
+    enum
+    {
+        OUTPUT_GROUND,
+        OUTPUT_ESCAPE,
+        OUTPUT_CSI,
+        OUTPUT_STRING,
+    } parser;
+    bool parameters;
+    uint32_t spaces;
+    uint32_t repeats;
+    uint32_t erases;
+} output;
+
+static void output_feed(const struct device *dev, uint8_t c)
+{
+    switch (output.parser)
+    {
+    case OUTPUT_GROUND:
+        if (c == '\x1b')
+        {
+            output.parser = OUTPUT_ESCAPE;
+        }
+        else if (c == ' ')
+        {
+            output.spaces++;
+        }
+        break;
+
+    case OUTPUT_ESCAPE:
+        // ESC 7 and ESC 8 are complete, DCS runs until ESC backslash
+        output.parameters = false;
+        output.parser = c == '[' ? OUTPUT_CSI : c == 'P' ? OUTPUT_STRING : OUTPUT_GROUND;
+        break;
+
+    case OUTPUT_CSI:
+        if (c < 0x40 || c > 0x7e)
+        {
+            output.parameters = true;
+            break;
+        }
+
+        output.parser = OUTPUT_GROUND;
+        if (c == 'b')
+        {
+            output.repeats++;
+        }
+        else if (c == 'X')
+        {
+            output.erases++;
+        }
+        else if (c == 'c' && !output.parameters && reply != NULL)
+        {
+            // the device attributes query comes last. The rx fifo holds
+            // the longest of the replies.
+            uart_emul_put_rx_data(dev, (const uint8_t *)reply, strlen(reply));
+        }
+        break;
+
+    case OUTPUT_STRING:
+        if (c == '\x1b')
+        {
+            output.parser = OUTPUT_ESCAPE;
+        }
+        break;
+    }
+}
+
+/* runs on the render context, for every byte the driver writes */
+static void capture_tx(const struct device *dev, size_t size, void *user_data)
+{
+    ARG_UNUSED(size);
+    ARG_UNUSED(user_data);
+
+    uint8_t data[64];
+    size_t length;
+    while ((length = uart_emul_get_tx_data(dev, data, sizeof(data))) > 0)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            output_feed(dev, data[i]);
+        }
+    }
+}
+
+static void reset_output(void)
+{
+    output.spaces = 0;
+    output.repeats = 0;
+    output.erases = 0;
+}
+
+static uint32_t get_frames(void)
+{
+    struct terminal_display_stats stats;
+    zassert_ok(terminal_display_get_stats(display, &stats));
+    return stats.frames;
+}
+
+static void wait_for_frames(uint32_t frames)
+{
+    while (get_frames() < frames)
+    {
+        k_msleep(1);
+    }
+}
+
+static void draw(void)
+{
+    const struct display_buffer_descriptor desc = {
+        .buf_size = sizeof(frame),
+        .width = WIDTH,
+        .height = HEIGHT,
+        .pitch = WIDTH,
+    };
+
+    const uint32_t frames = get_frames();
+    zassert_ok(display_write(display, 0, 0, &desc, frame));
+    wait_for_frames(frames + 1);
+}
+
+/* black and white pixels alternate, so every pixel is drawn on its own
+ * with two literal spaces in any color mode */
+static void draw_checkerboard(void)
+{
+    for (int y = 0; y < HEIGHT; y++)
+    {
+        for (int x = 0; x < WIDTH; x++)
+        {
+            memset(&frame[(y * WIDTH + x) * 3], (x + y) % 2 ? 0xff : 0x00, 3);
+        }
+    }
+    draw();
+}
+
+struct expected
+{
+    enum terminal_display_color_mode color_mode;
+    uint16_t rows;
+    uint16_t columns;
+    bool rep;
+    bool ech;
+};
+
+/* probes a terminal that answers with the given replies, and checks what
+ * the driver made of them */
+static void check_probe(const char *replies, const struct expected *expected)
+{
+    struct terminal_display_terminal_info before;
+    zassert_ok(terminal_display_get_terminal_info(display, &before));
+    draw_checkerboard();
+
+    reply = replies;
+    reset_output();
+    const uint32_t frames = get_frames();
+    const int64_t start = k_uptime_get();
+    zassert_ok(terminal_display_probe(display));
+    wait_for_frames(frames + 1);
+    const int64_t elapsed = k_uptime_get() - start;
+    reply = NULL;
+
+    struct terminal_display_terminal_info info;
+    zassert_ok(terminal_display_get_terminal_info(display, &info));
+    zassert_equal(info.color_mode, expected->color_mode, "Color mode %d instead of %d",
+                  info.color_mode, expected->color_mode);
+    zassert_equal(info.rows, expected->rows);
+    zassert_equal(info.columns, expected->columns);
+
+    // without an answer the probe gives up after the timeout, with one
+    // it's done as soon as the device attributes arrive
+    if (replies == NULL)
+    {
+        zassert_true(elapsed >= CONFIG_TERMINAL_DISPLAY_PROBE_TIMEOUT_MS);
+    }
+    else
+    {
+        zassert_true(elapsed < CONFIG_TERMINAL_DISPLAY_PROBE_TIMEOUT_MS);
+    }
+
+    // a new color mode redraws everything in it, the same one nothing
+    const uint32_t redrawn = before.color_mode != info.color_mode ? WIDTH * HEIGHT * 2 : 0;
+    zassert_equal(output.spaces, redrawn, "Redrew %u cells instead of %u", output.spaces, redrawn);
+
+    // one color, different from either of the checkerboard's, across the
+    // whole display leaves a long run in every row. REP is shorter than
+    // ECH and the CUF after it, so ECH only shows up without REP.
+    memset(frame, 0x80, sizeof(frame));
+    reset_output();
+    draw();
+    zassert_equal(output.repeats > 0, expected->rep, "REP used %u times", output.repeats);
+    zassert_equal(output.erases > 0, expected->ech && !expected->rep, "ECH used %u times",
+                  output.erases);
+}
+
+ZTEST(terminal_display_probe, test_xterm)
+{
+    const struct expected expected = {
+        .color_mode = TERMINAL_DISPLAY_COLOR_MODE_TRUECOLOR,
+        .rows = 50,
+        .columns = 160,
+        .rep = true,
+        .ech = true,
+    };
+
+    // RGB=8/8/8, Co=256, VT420
+    check_probe("\x1b[50;160R"
+                "\x1bP1+r524742=382f382f38\x1b\\"
+                "\x1bP1+r436f=323536\x1b\\"
+                "\x1b[?64;1;2;6;9;15;16;17;18;21;22;28c",
+                &expected);
+}
+
+ZTEST(terminal_display_probe, test_vte)
+{
+    const struct expected expected = {
+        .color_mode = TERMINAL_DISPLAY_COLOR_MODE_256,
+        .rows = 40,
+        .columns = 120,
+        .rep = true,
+        .ech = true,
+    };
+
+    // knows XTGETTCAP but neither capability, VT525
+    check_probe("\x1b[40;120R"
+                "\x1bP0+r524742\x1b\\"
+                "\x1bP0+r436f\x1b\\"
+                "\x1b[?65;1;9c",
+                &expected);
+}
+
+ZTEST(terminal_display_probe, test_vt220)
+{
+    const struct expected expected = {
+        .color_mode = TERMINAL_DISPLAY_COLOR_MODE_256,
+        .rows = 24,
+        .columns = 80,
+        .rep = false,
+        .ech = true,
+    };
+
+    check_probe("\x1b[24;80R"
+                "\x1b[?62;1;2;6;8c",
+                &expected);
+}
+
+ZTEST(terminal_display_probe, test_minicom)
+{
+    const struct expected expected = {
+        .color_mode = TERMINAL_DISPLAY_COLOR_MODE_256,
+        .rows = 24,
+        .columns = 80,
+        .rep = false,
+        .ech = false,
+    };
+
+    // a VT102
+    check_probe("\x1b[24;80R"
+                "\x1b[?1;2c",
+                &expected);
+}
+
+ZTEST(terminal_display_probe, test_no_answer)
+{
+    const struct expected expected = {
+        .color_mode = TERMINAL_DISPLAY_COLOR_MODE_256,
+    };
+
+    check_probe(NULL, &expected);
+}
+
+static void *probe_setup(void)
+{
+    zassert_true(device_is_ready(display), "Device is not ready");
+
+    // nothing answered the probe at boot
+    wait_for_frames(1);
+    uart_emul_flush_tx_data(terminal);
+    uart_emul_callback_tx_data_ready_set(terminal, capture_tx, NULL);
+
+    const uint32_t frames = get_frames();
+    zassert_ok(display_blanking_off(display));
+    wait_for_frames(frames + 1);
+
+    return NULL;
+}
+
+ZTEST_SUITE(terminal_display_probe, NULL, probe_setup, NULL, NULL, NULL);